@@ -0,0 +1,120 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "scorefile.h"
+#include "store.h"
+
+// Load benchmark for the legacy scores.txt path: writes a history of N
+// "name:wins" records (1M by default), then times a parse-only pass and a
+// full import into a fresh scores store, checking every record arrives.
+
+#define DEFAULT_RECORDS 1000000
+#define BENCH_TXT "/tmp/yahtzee_bench_scores.txt"
+#define BENCH_DB  "/tmp/yahtzee_bench_scores.db"
+
+typedef struct {
+    long records;
+    unsigned long long wins_sum;
+    Store *store;
+} BenchCtx;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void count_record(const char *name, int wins, void *ctx) {
+    BenchCtx *b = (BenchCtx*)ctx;
+    (void)name;
+    b->records++;
+    b->wins_sum += (unsigned)wins;
+}
+
+static void import_record(const char *name, int wins, void *ctx) {
+    BenchCtx *b = (BenchCtx*)ctx;
+    count_record(name, wins, ctx);
+    store_set_wins(b->store, name, (uint32_t)wins);
+}
+
+// Names vary in length so records straddle read boundaries at every offset
+static unsigned long long write_history(long n, size_t *bytes) {
+    FILE *f = fopen(BENCH_TXT, "w");
+    if (!f) return 0;
+
+    unsigned long long sum = 0;
+    for (long i = 0; i < n; i++) {
+        int wins = (int)((i * 7919) % 1000);
+        fprintf(f, "player_%ld%.*s:%d\n", i, (int)(i % 17), "_abcdefghijklmnop", wins);
+        sum += (unsigned)wins;
+    }
+    *bytes = (size_t)ftell(f);
+    fclose(f);
+    return sum;
+}
+
+static int run_pass(const char *label, scorefile_cb cb, BenchCtx *b, long n,
+                    unsigned long long want_sum, size_t bytes) {
+    int fd = open(BENCH_TXT, O_RDONLY);
+    if (fd < 0) {
+        perror(BENCH_TXT);
+        return -1;
+    }
+
+    double t0 = now_sec();
+    if (b->store) store_import_begin(b->store);
+    long parsed = scorefile_parse(fd, cb, b);
+    if (b->store) store_import_end(b->store);
+    double dt = now_sec() - t0;
+    close(fd);
+
+    printf("%-8s %8ld records  %8.1f ms  %8.1f MB/s  %6.0f ns/record\n",
+           label, parsed, dt * 1e3, (double)bytes / dt / 1e6, dt * 1e9 / (double)n);
+
+    if (parsed != n || b->records != n || b->wins_sum != want_sum) {
+        fprintf(stderr, "%s: expected %ld records (sum %llu), got %ld (sum %llu)\n",
+                label, n, want_sum, b->records, b->wins_sum);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long n = argc > 1 ? atol(argv[1]) : DEFAULT_RECORDS;
+    if (n <= 0) {
+        fprintf(stderr, "Usage: %s [records]\n", argv[0]);
+        return 1;
+    }
+
+    size_t bytes = 0;
+    unsigned long long want_sum = write_history(n, &bytes);
+    if (bytes == 0) {
+        perror(BENCH_TXT);
+        return 1;
+    }
+    printf("scores.txt: %ld records, %.1f MB, %d KB reads\n",
+           n, (double)bytes / 1e6, SCOREFILE_CHUNK / 1024);
+
+    BenchCtx parse = {0, 0, NULL};
+    int rc = run_pass("parse", count_record, &parse, n, want_sum, bytes);
+
+    unlink(BENCH_DB);
+    int created;
+    BenchCtx import = {0, 0, store_open(BENCH_DB, &created)};
+    if (!import.store) {
+        perror(BENCH_DB);
+        rc = -1;
+    } else {
+        if (run_pass("import", import_record, &import, n, want_sum, bytes) < 0) rc = -1;
+        printf("store:   %u players, %u slots\n", store_count(import.store), import.store->capacity);
+        store_close(import.store);
+    }
+
+    unlink(BENCH_TXT);
+    unlink(BENCH_DB);
+    return rc < 0 ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scoring.h"
+
+// Batch scoring benchmark: scores N random hands (1M by default, a few
+// with an invalid die, a quarter with the Joker flag set) one at a time
+// through the roll tables and then through each batch kernel this CPU
+// runs, checking every kernel matches the per-hand path exactly. Every
+// ordered roll is also checked with and without the Joker flag.
+
+#define DEFAULT_HANDS 1000000
+#define ROUNDS 5
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned next_rand(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (unsigned)((rng_state * 2685821657736338717ULL) >> 32);
+}
+
+// The per-hand path, as calculate_possible_scores takes it
+static void score_each(const unsigned char *dice, const unsigned char *joker, size_t n, short *out) {
+    for (size_t h = 0; h < n; h++) {
+        int d[5], s[SCORING_NUM_CATEGORIES];
+        for (int i = 0; i < 5; i++) d[i] = dice[i * n + h];
+        scoring_possible_scores(scoring_roll_index(d), joker[h], s);
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) out[c * n + h] = (short)s[c];
+    }
+}
+
+static long first_mismatch(const short *a, const short *b, size_t n) {
+    for (size_t i = 0; i < n * SCORING_NUM_CATEGORIES; i++) {
+        if (a[i] != b[i]) return (long)(i % n);
+    }
+    return -1;
+}
+
+// All 7776 ordered rolls, each with and without Joker, in one batch whose
+// length is not a multiple of any vector width so the tail is covered too
+static int check_exhaustive(ScoringIsa isa) {
+    size_t n = 7776 * 2 + 7;
+    unsigned char *dice = malloc(5 * n), *joker = malloc(n);
+    short *want = malloc(n * SCORING_NUM_CATEGORIES * sizeof(short));
+    short *got = malloc(n * SCORING_NUM_CATEGORIES * sizeof(short));
+    if (!dice || !joker || !want || !got) { perror("malloc"); exit(1); }
+
+    for (size_t h = 0; h < n; h++) {
+        size_t r = h % 7776;
+        for (int i = 0; i < 5; i++, r /= 6) dice[i * n + h] = (unsigned char)(r % 6 + 1);
+        joker[h] = h >= 7776;
+    }
+    score_each(dice, joker, n, want);
+    scoring_batch_isa(isa, dice, joker, n, got);
+    long bad = first_mismatch(want, got, n);
+
+    free(dice); free(joker); free(want); free(got);
+    return bad < 0;
+}
+
+int main(int argc, char *argv[]) {
+    long n = argc > 1 ? atol(argv[1]) : DEFAULT_HANDS;
+    if (n <= 0) {
+        fprintf(stderr, "Usage: %s [hands]\n", argv[0]);
+        return 1;
+    }
+    scoring_init();
+
+    unsigned char *dice = malloc(5 * (size_t)n), *joker = malloc((size_t)n);
+    short *want = malloc((size_t)n * SCORING_NUM_CATEGORIES * sizeof(short));
+    short *got = malloc((size_t)n * SCORING_NUM_CATEGORIES * sizeof(short));
+    if (!dice || !joker || !want || !got) { perror("malloc"); return 1; }
+
+    // Mostly Yahtzees and straights would be a different benchmark; plain
+    // uniform dice, one hand in 1000 with a 0 or 7 in it
+    for (long h = 0; h < n; h++) {
+        for (int i = 0; i < 5; i++) dice[i * n + h] = (unsigned char)(next_rand() % 6 + 1);
+        if (next_rand() % 1000 == 0) dice[(next_rand() % 5) * n + h] = (next_rand() & 1) ? 0 : 7;
+        joker[h] = next_rand() % 4 == 0;
+    }
+
+    printf("Scoring %ld hands, best of %d rounds\n", n, ROUNDS);
+
+    double base = 1e30;
+    for (int r = 0; r < ROUNDS; r++) {
+        double t0 = now_sec();
+        score_each(dice, joker, (size_t)n, want);
+        double t = now_sec() - t0;
+        if (t < base) base = t;
+    }
+    printf("  %-8s %8.2f ms  %7.1f Mhands/s\n", "per-hand", base * 1e3, n / base / 1e6);
+
+    int failed = 0;
+    ScoringIsa best = scoring_batch_best_isa();
+    for (ScoringIsa isa = SCORING_ISA_SCALAR; isa <= best; isa++) {
+        double t_min = 1e30;
+        for (int r = 0; r < ROUNDS; r++) {
+            memset(got, 0xff, (size_t)n * SCORING_NUM_CATEGORIES * sizeof(short));
+            double t0 = now_sec();
+            scoring_batch_isa(isa, dice, joker, (size_t)n, got);
+            double t = now_sec() - t0;
+            if (t < t_min) t_min = t;
+        }
+
+        long bad = first_mismatch(want, got, (size_t)n);
+        int exhaustive = check_exhaustive(isa);
+        printf("  %-8s %8.2f ms  %7.1f Mhands/s  %5.2fx  %s\n", scoring_isa_name(isa),
+               t_min * 1e3, n / t_min / 1e6, base / t_min,
+               bad < 0 && exhaustive ? "matches" : "MISMATCH");
+        if (bad >= 0) {
+            fprintf(stderr, "%s: hand %ld differs (dice %d %d %d %d %d, joker %d)\n",
+                    scoring_isa_name(isa), bad, dice[bad], dice[n + bad], dice[2 * n + bad],
+                    dice[3 * n + bad], dice[4 * n + bad], joker[bad]);
+        }
+        if (!exhaustive) fprintf(stderr, "%s: differs on the exhaustive roll check\n", scoring_isa_name(isa));
+        if (bad >= 0 || !exhaustive) failed = 1;
+    }
+
+    free(dice); free(joker); free(want); free(got);
+    return failed;
+}
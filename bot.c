@@ -0,0 +1,165 @@
+#include <string.h>
+#include <time.h>
+
+#include "bot.h"
+
+// Average score of each category under good play: "par" for medium, which
+// would rather bank 12 in Fours than 12 in Chance
+static const double par[SCORING_NUM_CATEGORIES] = {
+    2.1, 5.3, 8.6, 12.2, 15.7, 19.2, 21.7, 13.1, 22.6, 29.5, 32.7, 16.9, 22.0
+};
+
+static const char *level_names[BOT_LEVELS] = {"none", "easy", "medium", "hard"};
+
+const char *bot_level_name(BotLevel level) {
+    return (level >= 0 && level < BOT_LEVELS) ? level_names[level] : "?";
+}
+
+// Reading the thread CPU clock is a system call, so a bot with no budget
+// (budget_ns <= 0) never does it
+static long thread_cpu_ns(const Bot *b) {
+    if (b->budget_ns <= 0) return 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void bot_init(Bot *b, BotLevel level, long budget_ns) {
+    memset(b, 0, sizeof(*b));
+    b->level = level;
+    b->budget_ns = budget_ns;
+    reroll_init();
+}
+
+// Highest level whose evaluation is expected to fit in the budget.
+// A level that is skipped has its estimate decayed, so one slow decision
+// (a page fault, a cold cache) does not demote the bot for good.
+static BotLevel affordable_level(Bot *b, BotLevel want) {
+    BotLevel lv = want;
+    while (lv > BOT_EASY && b->budget_ns > 0 && b->est_ns[lv] > b->budget_ns) {
+        b->est_ns[lv] -= b->est_ns[lv] / 16;
+        lv--;
+    }
+    return lv;
+}
+
+static void charge(Bot *b, BotLevel lv, long ns) {
+    b->est_ns[lv] = b->est_ns[lv] ? (3 * b->est_ns[lv] + ns) / 4 : ns;
+}
+
+static void account(Bot *b, long ns, BotLevel used) {
+    b->decisions++;
+    if (used < b->level) b->downgrades++;
+    if (b->budget_ns > 0 && ns > b->budget_ns) b->overruns++;
+    if (ns > b->max_ns) b->max_ns = ns;
+}
+
+// Easy: hold every die showing the most common face (the higher on a tie)
+static int easy_hold(const int dice[5]) {
+    int counts[7] = {0}, face = 1;
+    for (int i = 0; i < 5; i++) counts[dice[i]]++;
+    for (int f = 2; f <= 6; f++) if (counts[f] >= counts[face]) face = f;
+    if (counts[face] == 5) return REROLL_HOLD_ALL;
+
+    int mask = 0;
+    for (int i = 0; i < 5; i++) if (dice[i] == face) mask |= 1 << i;
+    return mask;
+}
+
+// Medium: solver_turn's shape for this turn alone, where a final roll is
+// worth its best points above par in an open category
+static void medium_turn(const SolverState *s, SolverTurn *out) {
+    double ev[SCORING_NUM_ROLLS], keep_ev[REROLL_NUM_KEEPS];
+    for (int r = 0; r < SCORING_NUM_ROLLS; r++) {
+        int pts[SCORING_NUM_CATEGORIES];
+        scoring_possible_scores(r, s->yahtzee, pts);
+        double best = -1e9;
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) {
+            if (s->used & (1 << c)) continue;
+            if (pts[c] - par[c] > best) best = pts[c] - par[c];
+        }
+        ev[r] = best;
+        out->stand[r] = (float)best;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        reroll_expect_all(ev, keep_ev);
+        for (int k = 0; k < REROLL_NUM_KEEPS; k++) out->keep[pass][k] = (float)keep_ev[k];
+        if (pass == 1) break;
+        for (int r = 0; r < SCORING_NUM_ROLLS; r++) {
+            int n;
+            const short *keeps = reroll_roll_keeps(r, &n);
+            for (int j = 0; j < n; j++) if (keep_ev[keeps[j]] > ev[r]) ev[r] = keep_ev[keeps[j]];
+        }
+    }
+}
+
+int bot_choose_hold(Bot *b, const StrategyTable *t, const SolverState *s,
+                    const int dice[5], int rerolls_left) {
+    long start = thread_cpu_ns(b);
+    BotLevel lv = b->level;
+    if (lv == BOT_HARD && (!t || !t->values)) lv = BOT_MEDIUM;
+
+    // Hard and medium evaluate the whole turn once and reuse it for the
+    // second reroll; the key carries the level the turn was evaluated at
+    uint32_t key = (solver_state_index(s->used, s->upper, s->yahtzee) + 1) * BOT_LEVELS;
+    BotLevel evaluated = BOT_NONE;
+    if (lv > BOT_EASY && b->turn_key != key + lv) {
+        lv = affordable_level(b, lv);
+        if (lv > BOT_EASY && b->turn_key != key + lv) {
+            if (lv == BOT_HARD) solver_turn(t, s, &b->turn);
+            else medium_turn(s, &b->turn);
+            b->turn_key = key + lv;
+            evaluated = lv;
+        }
+    }
+
+    int mask;
+    if (lv > BOT_EASY) {
+        double values[32];
+        mask = solver_turn_holds(&b->turn, dice, rerolls_left, values);
+    } else {
+        mask = easy_hold(dice);
+    }
+
+    // The turn evaluation is nearly all of a decision that does one
+    long ns = thread_cpu_ns(b) - start;
+    if (evaluated) charge(b, evaluated, ns);
+    account(b, ns, lv);
+    return mask;
+}
+
+int bot_choose_category(Bot *b, const StrategyTable *t, const SolverState *s,
+                        const int dice[5], const int points[SCORING_NUM_CATEGORIES], int allowed) {
+    long start = thread_cpu_ns(b);
+    BotLevel lv = b->level;
+    if (lv == BOT_HARD && (!t || !t->values)) lv = BOT_MEDIUM;
+
+    // A category is at most 13 table lookups at any level, so unlike a
+    // hold there is nothing to trade down; it is only measured
+    int choice = -1;
+    if (lv == BOT_HARD) {
+        SolverChoice opt[SCORING_NUM_CATEGORIES];
+        int n = solver_score_options(t, s, scoring_roll_index(dice), opt);
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            if (!(allowed & (1 << opt[i].category))) continue;
+            if (best < 0 || opt[i].value > opt[best].value) best = i;
+        }
+        if (best >= 0) choice = opt[best].category;
+        else lv = BOT_MEDIUM;
+    }
+
+    // Easy takes the most points; medium the most points above par
+    if (choice < 0) {
+        double best = 0;
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) {
+            if (!(allowed & (1 << c))) continue;
+            double v = points[c] - (lv == BOT_MEDIUM ? par[c] : 0.0);
+            if (choice < 0 || v > best) { best = v; choice = c; }
+        }
+    }
+
+    account(b, thread_cpu_ns(b) - start, lv);
+    return choice;
+}
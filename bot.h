@@ -0,0 +1,64 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <stdint.h>
+
+#include "solver.h"
+
+// Decision making for server-run players.
+//
+// Strength levels differ in how far they look:
+//   easy    keeps the most common face and takes the most points now
+//   medium  plays the best hold for this turn's points (exact reroll odds,
+//           no look at the rest of the game) and scores against par
+//   hard    optimal play from the strategy table
+//
+// Every decision runs under a CPU budget (thread CPU time, so a bot that
+// is preempted is not charged). Each level keeps a running estimate of
+// what one evaluation costs; when that estimate does not fit in what is
+// left of the budget the bot drops to the next cheaper level for that
+// decision instead of overrunning. A budget of 0 means unlimited (and no
+// timing at all). Hard also drops to medium when no strategy table is
+// mapped.
+
+typedef enum {
+    BOT_NONE = 0,
+    BOT_EASY,
+    BOT_MEDIUM,
+    BOT_HARD,
+    BOT_LEVELS
+} BotLevel;
+
+#define BOT_DEFAULT_BUDGET_US 1000
+
+typedef struct {
+    BotLevel level;
+    long budget_ns;                        // per decision, 0 = unlimited
+    long est_ns[BOT_LEVELS];               // running cost of one evaluation
+
+    uint32_t turn_key;                     // state and level `turn` was evaluated for, 0 = none
+    SolverTurn turn;
+
+    unsigned long decisions;
+    unsigned long downgrades;              // decisions made below `level`
+    unsigned long overruns;                // decisions that still went over budget
+    long max_ns;                           // slowest decision
+} Bot;
+
+const char *bot_level_name(BotLevel level);
+
+void bot_init(Bot *b, BotLevel level, long budget_ns);
+
+// Dice to hold with `rerolls_left` (1 or 2) to go: bit i = keep dice[i],
+// REROLL_HOLD_ALL = stand. `s` is the scorecard state at the start of the
+// turn; `t` may be NULL.
+int bot_choose_hold(Bot *b, const StrategyTable *t, const SolverState *s,
+                    const int dice[5], int rerolls_left);
+
+// Category (0..12) to score the final dice in. `points` are the scores
+// the server offers for each category (Joker rules applied) and `allowed`
+// is a bit mask of the categories the player may pick.
+int bot_choose_category(Bot *b, const StrategyTable *t, const SolverState *s,
+                        const int dice[5], const int points[SCORING_NUM_CATEGORIES], int allowed);
+
+#endif
@@ -0,0 +1,137 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ckpt.h"
+
+#define CKPT_MAGIC   0x54504b43u            // "CKPT"
+#define CKPT_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nslots;
+    uint32_t slot_size;
+} CkptFileHdr;
+
+typedef struct {
+    uint64_t seq;                           // 0 = never written
+    uint32_t len;
+    uint32_t sum;                           // over seq, len and the data
+} CkptBufHdr;
+
+struct Checkpoint {
+    int fd;
+    int nslots;
+    size_t slot_size;
+    uint64_t *seq;                          // newest sequence number per slot
+    unsigned char *buf;                     // one slot's write buffer per slot
+};
+
+static uint32_t checksum(const CkptBufHdr *h, const unsigned char *data, size_t len) {
+    uint32_t x = 2166136261u;               // FNV-1a
+    const unsigned char *p = (const unsigned char*)h;
+    for (size_t i = 0; i < offsetof(CkptBufHdr, sum); i++) x = (x ^ p[i]) * 16777619u;
+    for (size_t i = 0; i < len; i++) x = (x ^ data[i]) * 16777619u;
+    return x;
+}
+
+static size_t buf_bytes(const Checkpoint *c) {
+    return sizeof(CkptBufHdr) + c->slot_size;
+}
+
+static off_t buf_offset(const Checkpoint *c, int slot, int which) {
+    return (off_t)(sizeof(CkptFileHdr) + ((size_t)slot * 2 + (size_t)which) * buf_bytes(c));
+}
+
+// Sequence number of one buffer if its contents are intact, else 0
+static uint64_t read_buf(Checkpoint *c, int slot, int which, unsigned char *scratch) {
+    size_t n = buf_bytes(c);
+    if (pread(c->fd, scratch, n, buf_offset(c, slot, which)) != (ssize_t)n) return 0;
+
+    CkptBufHdr h;
+    memcpy(&h, scratch, sizeof(h));
+    if (h.seq == 0 || h.len > c->slot_size) return 0;
+    if (checksum(&h, scratch + sizeof(h), h.len) != h.sum) return 0;
+    return h.seq;
+}
+
+Checkpoint *ckpt_open(const char *path, int nslots, size_t slot_size) {
+    Checkpoint *c = (Checkpoint*)calloc(1, sizeof(Checkpoint));
+    if (!c) return NULL;
+    c->nslots = nslots;
+    c->slot_size = slot_size;
+    c->seq = (uint64_t*)calloc((size_t)nslots, sizeof(uint64_t));
+    c->buf = (unsigned char*)malloc((size_t)nslots * buf_bytes(c));
+    c->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (!c->seq || !c->buf || c->fd < 0) {
+        ckpt_close(c);
+        return NULL;
+    }
+
+    CkptFileHdr want = {CKPT_MAGIC, CKPT_VERSION, (uint32_t)nslots, (uint32_t)slot_size};
+    CkptFileHdr have;
+    if (pread(c->fd, &have, sizeof(have), 0) != (ssize_t)sizeof(have) ||
+        memcmp(&have, &want, sizeof(want)) != 0) {
+        if (ftruncate(c->fd, 0) < 0 ||
+            pwrite(c->fd, &want, sizeof(want), 0) != (ssize_t)sizeof(want) ||
+            ftruncate(c->fd, buf_offset(c, nslots, 0)) < 0) {
+            ckpt_close(c);
+            return NULL;
+        }
+    }
+
+    for (int s = 0; s < nslots; s++) {
+        uint64_t a = read_buf(c, s, 0, c->buf), b = read_buf(c, s, 1, c->buf);
+        c->seq[s] = a > b ? a : b;
+    }
+    return c;
+}
+
+int ckpt_write(Checkpoint *c, int slot, const void *data, size_t len) {
+    if (slot < 0 || slot >= c->nslots || len > c->slot_size) return -1;
+
+    unsigned char *b = c->buf + (size_t)slot * buf_bytes(c);
+    CkptBufHdr h = {c->seq[slot] + 1, (uint32_t)len, 0};
+    memcpy(b + sizeof(h), data, len);
+    h.sum = checksum(&h, b + sizeof(h), len);
+    memcpy(b, &h, sizeof(h));
+
+    // Odd sequence numbers live in buffer 1, even ones in buffer 0, so the
+    // newest intact copy is never the one being overwritten
+    size_t n = sizeof(h) + len;
+    if (pwrite(c->fd, b, n, buf_offset(c, slot, (int)(h.seq & 1))) != (ssize_t)n) return -1;
+    c->seq[slot] = h.seq;
+    return 0;
+}
+
+long ckpt_read(Checkpoint *c, int slot, void *out, size_t cap) {
+    if (slot < 0 || slot >= c->nslots) return -1;
+
+    unsigned char *scratch = (unsigned char*)malloc(buf_bytes(c));
+    if (!scratch) return -1;
+
+    long len = -1;
+    uint64_t best = 0;
+    for (int which = 0; which < 2; which++) {
+        uint64_t seq = read_buf(c, slot, which, scratch);
+        if (seq <= best) continue;
+        CkptBufHdr h;
+        memcpy(&h, scratch, sizeof(h));
+        if (h.len > cap) continue;
+        memcpy(out, scratch + sizeof(h), h.len);
+        best = seq;
+        len = (long)h.len;
+    }
+    free(scratch);
+    return len;
+}
+
+void ckpt_close(Checkpoint *c) {
+    if (!c) return;
+    if (c->fd >= 0) close(c->fd);
+    free(c->seq);
+    free(c->buf);
+    free(c);
+}
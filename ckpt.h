@@ -0,0 +1,33 @@
+#ifndef CKPT_H
+#define CKPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Double-buffered checkpoint file.
+//
+// The file holds a fixed number of slots (one per lobby), and every slot
+// has two buffers on disk. A write goes, in one pwrite, to the buffer not
+// holding the newest copy, stamped with a sequence number and a checksum.
+// A crash part-way through a write can therefore only damage the older
+// copy, and a reader takes the newest buffer whose checksum holds. Each
+// slot must have a single writer; different slots may be written from
+// different threads at once. Nothing is fsync'd: the file survives the
+// server process dying, not the machine losing power.
+
+typedef struct Checkpoint Checkpoint;
+
+// Open or create `path` for `nslots` slots of up to `slot_size` bytes.
+// A file laid out for other sizes is started afresh. NULL on error.
+Checkpoint *ckpt_open(const char *path, int nslots, size_t slot_size);
+
+// Store `len` bytes as the newest copy of `slot`. Returns 0 or -1.
+int ckpt_write(Checkpoint *c, int slot, const void *data, size_t len);
+
+// Copy the newest intact copy of `slot` into `out`. Returns its length,
+// or -1 if the slot has never been written (or both copies are damaged).
+long ckpt_read(Checkpoint *c, int slot, void *out, size_t cap);
+
+void ckpt_close(Checkpoint *c);
+
+#endif
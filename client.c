@@ -1,3 +1,4 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,18 +6,259 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+#include "protocol.h"
+#include "ring.h"
+#include "scoring.h"
 
 #define BUFFER_SIZE 2048
 #define NAME_SIZE 50
 #define FIFO_DIR "/tmp/yahtzee"
 #define SERVER_FIFO "/tmp/yahtzee/server_fifo"
 
-int main() {
+// Active transport for the current connection: the shm rings when the
+// server accepted them, otherwise the FIFO pair.
+static RingSegment *ring;
+
+static ssize_t conn_write(int write_fd, const void *buf, size_t len) {
+    if (ring) return ring_write(&ring->to_server, buf, len);
+    return write(write_fd, buf, len);
+}
+
+static ssize_t conn_read(int read_fd, void *buf, size_t len) {
+    if (!ring) return read(read_fd, buf, len);
+
+    while (1) {
+        ssize_t n = ring_read(&ring->to_client, buf, len);
+        if (n >= 0) return n;
+
+        // Wake up once a second to notice a server that died without closing
+        if (ring_wait(&ring->to_client, 1000) == 0) {
+            struct pollfd pfd;
+            pfd.fd = read_fd;
+            pfd.events = 0;
+            if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR))) return 0;
+        }
+    }
+}
+
+// Seat token the server handed us (MSG_SEAT). It is the only credential
+// for the seat, and every player on this machine runs under the same uid,
+// so it is kept per process. With --seat-file it is also written to that
+// file (mode 0600), and running the client again with the same option
+// takes the seat back after a lost connection or a server restart.
+static uint64_t seat_token;
+static char seat_file[256];
+
+static uint64_t load_seat_token(void) {
+    uint64_t token = 0;
+    if (seat_token || seat_file[0] == '\0') return seat_token;
+
+    FILE *f = fopen(seat_file, "r");
+    if (!f) return 0;
+    if (fscanf(f, "%" SCNx64, &token) != 1) token = 0;
+    fclose(f);
+    return token;
+}
+
+static void save_seat_token(ProtoReader *r) {
+    int lobby = proto_get_u8(r);
+    int player = proto_get_u8(r);
+    uint64_t token = 0;
+    for (int i = 0; i < 8; i++) token |= (uint64_t)proto_get_u8(r) << (8 * i);
+    if (r->bad || token == 0) return;
+    seat_token = token;
+
+    if (seat_file[0] == '\0') {
+        printf("(Seat %d in lobby %d: start the client with --seat-file FILE to be able to rejoin)\n",
+               player + 1, lobby + 1);
+        return;
+    }
+
+    int fd = open(seat_file, O_CREAT | O_WRONLY | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror(seat_file);
+        return;
+    }
+    fchmod(fd, 0600);              // the file may predate us with looser bits
+    char line[32];
+    int len = snprintf(line, sizeof(line), "%016" PRIx64 "\n", token);
+    if (write(fd, line, (size_t)len) != len) perror(seat_file);
+    close(fd);
+    printf("(Seat %d in lobby %d saved: if the connection drops, run the client "
+           "again with --seat-file %s to rejoin)\n", player + 1, lobby + 1, seat_file);
+}
+
+// Drop `token` once its seat is gone (match over or token refused). The
+// file is only removed while it still holds that token.
+static void forget_seat_token(uint64_t token) {
+    if (token == 0) return;
+    if (seat_token == token) seat_token = 0;
+    if (seat_file[0] != '\0') {
+        uint64_t saved = 0;
+        FILE *f = fopen(seat_file, "r");
+        if (f) {
+            if (fscanf(f, "%" SCNx64, &saved) != 1) saved = 0;
+            fclose(f);
+        }
+        if (saved == token) unlink(seat_file);
+    }
+}
+
+static int read_exact(int fd, unsigned char *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, buf + got, len - got);
+        if (n <= 0) return -1;
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+// The first frame (MSG_HELLO or MSG_REJECT) always arrives over the FIFO.
+// Read exactly that frame so nothing after it is taken from the pipe
+// before we know whether to switch to the rings.
+static int read_first_frame(int read_fd, unsigned char *buf, ProtoFrame *f) {
+    if (read_exact(read_fd, buf, PROTO_HEADER_SIZE) < 0) return -1;
+    size_t len = (size_t)buf[2] | ((size_t)buf[3] << 8);
+    if (buf[1] != PROTO_VERSION || len > PROTO_MAX_PAYLOAD) return -1;
+    if (read_exact(read_fd, buf + PROTO_HEADER_SIZE, len) < 0) return -1;
+
+    f->type = (MsgType)buf[0];
+    f->payload = buf + PROTO_HEADER_SIZE;
+    f->len = len;
+    return 0;
+}
+
+
+// Text renderer: turns protocol frames into the classic terminal screens
+
+static void render_prompt(ProtoReader *r) {
+    int kind = proto_get_u8(r);
+    int min = proto_get_u8(r);
+    int max = proto_get_u8(r);
+    int rerolls = proto_get_u8(r);
+
+    switch (kind) {
+    case PROMPT_NAME:
+        printf("Enter your name: ");
+        break;
+    case PROMPT_PLAYERS:
+        printf("\n[HOST SETUP] Enter number of players for this game (%d-%d): ", min, max);
+        break;
+    case PROMPT_REROLL:
+        printf("\nRerolls left: %d. Reroll? (Y/N): ", rerolls);
+        break;
+    case PROMPT_WHICH_DICE:
+        printf("Which dice? (e.g., 1 3 5): ");
+        break;
+    case PROMPT_CATEGORY:
+        if (min <= 1) printf("\nChoose category (%d-%d): ", min, max);
+        else          printf("\nChoose LOWER category (%d-%d): ", min, max);
+        break;
+    case PROMPT_BOTS:
+        printf("[HOST SETUP] Fill the empty seats with bots? "
+               "(0 = wait for players, 1 = easy, 2 = medium, 3 = hard): ");
+        break;
+    default:
+        printf("> ");
+        break;
+    }
+}
+
+static void render_dice(ProtoReader *r) {
+    int label = proto_get_u8(r);
+    printf("%s:", label == DICE_REROLLED ? "New dice" : "Your dice");
+    for (int i = 0; i < 5; i++) printf(" [%d]", proto_get_u8(r));
+    printf("\n");
+}
+
+static void render_options(ProtoReader *r) {
+    int count = proto_get_u8(r);
+    printf("\n=== SCORING OPTIONS ===\n");
+    for (int k = 0; k < count && !r->bad; k++) {
+        int cat = proto_get_u8(r);
+        int pts = proto_get_i16(r);
+        printf("%2d. %-20s | %d points\n", cat + 1, scoring_category_name(cat), pts);
+    }
+}
+
+static void render_scorecard(ProtoReader *r) {
+    printf("\nCurrent Score:\nUpper Section\n");
+    for (int i = 0; i < SCORING_NUM_CATEGORIES; i++) {
+        if (i == 6) printf("\nLower Section\n");
+        int score = proto_get_i16(r);
+        int scored = proto_get_u8(r);
+        printf("%2d. %-14s | %d %s\n", i + 1, scoring_category_name(i), score,
+               scored ? "(Scored)" : "(Unscored)");
+    }
+
+    int bonus = proto_get_u8(r);
+    int upper_total = proto_get_i16(r);
+    int yahtzee_bonus = proto_get_i16(r);
+
+    if (!bonus) {
+        int pts_to_bonus = (upper_total < 63) ? (63 - upper_total) : 0;
+        printf("\nYou need %d more points in the UPPER SECTION to receive the 35-point bonus.\n",
+               pts_to_bonus);
+    } else {
+        printf("\nUpper bonus achieved! (+35)\n");
+    }
+    if (yahtzee_bonus >= 0) printf("Yahtzee bonus total: %d\n", yahtzee_bonus);
+}
+
+static void render_game_over(ProtoReader *r) {
+    int my_score = proto_get_i16(r);
+    int winner = proto_get_i8(r);
+    int count = proto_get_u8(r);
+
+    int players[8], scores[8];
+    const char *names[8];
+    if (count > 8) count = 8;
+    for (int k = 0; k < count; k++) {
+        players[k] = proto_get_u8(r);
+        scores[k] = proto_get_i16(r);
+        names[k] = proto_get_str(r);
+    }
+
+    printf("\n=== GAME OVER ===\nYour final score: %d\n", my_score);
+
+    int shown = 0;
+    for (int k = 0; k < count && winner >= 0; k++) {
+        if (players[k] != winner) continue;
+        printf("Winner: %s (Player %d) with %d\n", names[k], winner + 1, scores[k]);
+        shown = 1;
+    }
+    if (!shown) printf("Winner: N/A\n");
+
+    printf("\nFinal Scores:\n");
+    for (int k = 0; k < count; k++) {
+        printf("Player %d (%s): %d\n", players[k] + 1, names[k], scores[k]);
+    }
+}
+
+int main(int argc, char *argv[]) {
     char client_write_fifo[256];
     char client_read_fifo[256];
     char buffer[BUFFER_SIZE];
     char input[256];
+    char ring_name[RING_NAME_SIZE];
     int server_fd, write_fd, read_fd;
+    int use_ring = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipe") == 0) {
+            use_ring = 0;
+        } else if (strcmp(argv[i], "--seat-file") == 0 && i + 1 < argc) {
+            snprintf(seat_file, sizeof(seat_file), "%s", argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--pipe] [--seat-file FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    snprintf(ring_name, sizeof(ring_name), "/yahtzee_ring_%d", getpid());
 
     // Persist player name across rematches within this client process
     static char saved_name[NAME_SIZE] = {0};
@@ -53,6 +295,15 @@ int main() {
     while (1) {
         printf("Connecting to server...\n");
 
+        // Fresh ring segment per connection; the server maps it by name
+        ring = NULL;
+        RingSegment *offered = NULL;
+        if (use_ring) {
+            shm_unlink(ring_name);
+            offered = ring_segment_create(ring_name);
+            if (!offered) perror("ring setup failed, using pipes");
+        }
+
         // Open server FIFO and send our FIFO name
         server_fd = open(SERVER_FIFO, O_WRONLY);
         if (server_fd < 0) {
@@ -61,11 +312,16 @@ int main() {
             break;
         }
 
-        // Send our FIFO name to server
+        // Send our FIFO name to server, with a seat token from a match we
+        // were cut off from
+        uint64_t token = load_seat_token();
         {
             char line[512];
+            int len = snprintf(line, sizeof(line), "%s", client_write_fifo);
+            if (offered) len += snprintf(line + len, sizeof(line) - len, " ring=%s", ring_name);
+            if (token) len += snprintf(line + len, sizeof(line) - len, " token=%016" PRIx64, token);
             // send newline so server can parse one FIFO path per line
-            snprintf(line, sizeof(line), "%s\n", client_write_fifo);
+            snprintf(line + len, sizeof(line) - len, "\n");
             if (write(server_fd, line, strlen(line)) < 0) {
                 perror("write to server fifo failed");
             }
@@ -86,16 +342,60 @@ int main() {
             break;
         }
 
+        // Handshake: MSG_HELLO says which transport to use, MSG_REJECT refuses us
+        static unsigned char first[PROTO_MAX_FRAME];
+        ProtoFrame f;
+        int accepted = 0;
+        int got;
+        while ((got = read_first_frame(read_fd, first, &f)) == 0 && f.type == MSG_QUEUED) {
+            // Waiting room: the server lets us in on its own, just keep reading
+            ProtoReader r;
+            proto_reader_init(&r, &f);
+            int pos = proto_get_i16(&r);
+            int waiting = proto_get_i16(&r);
+            printf("All lobbies are busy. Waiting room: you are %d of %d in line...\n", pos, waiting);
+            fflush(stdout);
+        }
+        if (got < 0) {
+            printf("\nServer disconnected\n");
+        } else if (f.type == MSG_HELLO) {
+            ProtoReader r;
+            proto_reader_init(&r, &f);
+            if (proto_get_u8(&r) && offered) ring = offered;
+            int rejoined = f.len >= 2 && proto_get_u8(&r);
+            if (token && !rejoined) forget_seat_token(token);   // that seat is gone
+            if (rejoined) printf("✓ Rejoined your match in progress\n");
+            accepted = 1;
+        } else if (f.type == MSG_REJECT) {
+            ProtoReader r;
+            proto_reader_init(&r, &f);
+            printf("%s", proto_get_str(&r));
+        }
+
+        if (offered) {
+            shm_unlink(ring_name);     // both ends are mapped (or never will be)
+            if (ring != offered) ring_segment_unmap(offered);
+        }
+
+        if (!accepted) {
+            close(read_fd);
+            close(write_fd);
+            break;
+        }
+
         printf("✓ Connected to server!\n");
         printf("===============================================\n\n");
 
         int saw_game_over = 0;
+        int stop = 0;
+        static ProtoParser parser;
+        proto_parser_init(&parser);
+
+        // Main communication loop for single game: feed whatever arrived
+        // into the frame parser and act on each complete message
+        while (!stop) {
+            int n = (int)conn_read(read_fd, buffer, sizeof(buffer));
 
-        // Main communication loop for single game
-        while (1) {
-        memset(buffer, 0, BUFFER_SIZE);
-        int n = read(read_fd, buffer, BUFFER_SIZE - 1);
-        
             if (n <= 0) {
                 if (n < 0) {
                     perror("\nConnection error");
@@ -104,69 +404,86 @@ int main() {
                 }
                 break;
             }
-        
-            // Display what server sent
-            printf("%s", buffer);
-            fflush(stdout);
-
-            if (strstr(buffer, "=== GAME OVER ===")) {
-                saw_game_over = 1;
-            }
-        
-        // Check if server is asking for input
-        int needs_input = 0;
 
-        // Common gameplay prompts
-        if (strstr(buffer, "Enter your name")) needs_input = 1;
-        if (strstr(buffer, "Reroll?")) needs_input = 1;
-        if (strstr(buffer, "Which dice")) needs_input = 1;
-        if (strstr(buffer, "Choose category")) needs_input = 1;
-        if (strstr(buffer, "Choose LOWER category")) needs_input = 1;
-        if (strstr(buffer, "Choose where")) needs_input = 1;
+            size_t off = 0;
+            while (!stop && off < (size_t)n) {
+                off += proto_parser_feed(&parser, buffer + off, (size_t)n - off);
 
-        // Host lobby prompt
-        if (strstr(buffer, "Enter number of players")) needs_input = 1;
+                int rc = 0;
+                while (!stop && (rc = proto_parser_next(&parser, &f)) == 1) {
+                    ProtoReader r;
+                    proto_reader_init(&r, &f);
 
-        {
-            size_t len = strlen(buffer);
-            if (len >= 2 && buffer[len - 2] == ':' && buffer[len - 1] == ' ') {
-                needs_input = 1;
-            }
-        }
+                    switch (f.type) {
+                    case MSG_TEXT:
+                        fwrite(f.payload, 1, f.len, stdout);
+                        break;
+                    case MSG_DICE:
+                        render_dice(&r);
+                        break;
+                    case MSG_OPTIONS:
+                        render_options(&r);
+                        break;
+                    case MSG_SCORECARD:
+                        render_scorecard(&r);
+                        break;
+                    case MSG_GAME_OVER:
+                        render_game_over(&r);
+                        saw_game_over = 1;
+                        forget_seat_token(load_seat_token());
+                        break;
+                    case MSG_SEAT:
+                        save_seat_token(&r);
+                        break;
+                    case MSG_PROMPT: {
+                        int kind = f.payload[0];
+                        render_prompt(&r);
 
-            if (needs_input) {
-                // Auto-fill name on rematch so user doesn't need to retype it.
-                if (strstr(buffer, "Enter your name")) {
-                    if (saved_name[0] == '\0') {
-                        printf("(This name will be reused for rematches)\n> ");
-                        fflush(stdout);
-                        if (fgets(input, sizeof(input), stdin) == NULL) {
-                            break;
+                        // Auto-fill name on rematch so user doesn't need to retype it.
+                        if (kind == PROMPT_NAME) {
+                            if (saved_name[0] == '\0') {
+                                printf("(This name will be reused for rematches)\n> ");
+                                fflush(stdout);
+                                if (fgets(input, sizeof(input), stdin) == NULL) {
+                                    stop = 1;
+                                    break;
+                                }
+                                input[strcspn(input, "\n")] = '\0';
+                                strncpy(saved_name, input, sizeof(saved_name) - 1);
+                                saved_name[sizeof(saved_name) - 1] = '\0';
+                            }
+                            snprintf(input, sizeof(input), "%s\n", saved_name);
+                        } else {
+                            fflush(stdout);
+                            if (fgets(input, sizeof(input), stdin) == NULL) {
+                                stop = 1;
+                                break;
+                            }
                         }
-                        input[strcspn(input, "\n")] = '\0';
-                        strncpy(saved_name, input, sizeof(saved_name) - 1);
-                        saved_name[sizeof(saved_name) - 1] = '\0';
-                    }
 
-                    char line[128];
-                    snprintf(line, sizeof(line), "%s\n", saved_name);
-                    if (write(write_fd, line, strlen(line)) < 0) {
-                        perror("Send failed");
+                        if (conn_write(write_fd, input, strlen(input)) < 0) {
+                            perror("Send failed");
+                            stop = 1;
+                        }
                         break;
                     }
-                    continue;
-                }
-
-                // Otherwise, normal interactive input
-                if (fgets(input, sizeof(input), stdin) != NULL) {
-                    if (write(write_fd, input, strlen(input)) < 0) {
-                        perror("Send failed");
-                        break;
+                    default:
+                        break;      // unknown message types are skipped
                     }
                 }
+                if (rc < 0) {
+                    printf("\nProtocol error\n");
+                    stop = 1;
+                }
             }
+            fflush(stdout);
         }
 
+        if (ring) {
+            ring_close(&ring->to_server);
+            ring_segment_unmap(ring);
+            ring = NULL;
+        }
         close(read_fd);
         close(write_fd);
 
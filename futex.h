@@ -0,0 +1,28 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Shared (not FUTEX_PRIVATE) futex operations: the waiters and wakers live
+// in different processes mapping the same memory.
+
+static inline long futex_wait(_Atomic uint32_t *addr, uint32_t expected, int timeout_ms) {
+    struct timespec ts, *tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    return syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT, expected, tsp, NULL, 0);
+}
+
+static inline void futex_wake(_Atomic uint32_t *addr, int count) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+#endif
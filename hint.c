@@ -0,0 +1,61 @@
+#include <string.h>
+
+#include "futex.h"
+#include "hint.h"
+#include "snapshot.h"
+
+#define HINT_CACHE_BITS 6                  // 64 states, direct-mapped, worker-private
+
+static HintTurn cache[1 << HINT_CACHE_BITS];
+
+static uint32_t state_key(const SolverState *s) {
+    return solver_state_index(s->used, s->upper, s->yahtzee) + 1;
+}
+
+void hint_request(HintSlot *slot, const SolverState *s, _Atomic uint32_t *signal) {
+    uint32_t key = state_key(s);
+    if (atomic_exchange(&slot->want, key) == key) return;
+
+    atomic_fetch_add(signal, 1);
+    futex_wake(signal, 1);
+}
+
+int hint_lookup(const HintSlot *slot, const SolverState *s, SolverTurn *out) {
+    // Cheap check first so a miss does not copy the whole turn
+    uint32_t key = state_key(s);
+    if (__atomic_load_n(&slot->ready.key, __ATOMIC_ACQUIRE) != key) return 0;
+
+    HintTurn copy;
+    seqlock_read(&slot->seq, &copy, &slot->ready, sizeof(copy));
+    if (copy.key != key) return 0;
+
+    memcpy(out, &copy.turn, sizeof(*out));
+    return 1;
+}
+
+int hint_service(HintSlot *slots, int n, const StrategyTable *t) {
+    int filled = 0;
+    for (int i = 0; i < n; i++) {
+        HintSlot *slot = &slots[i];
+        uint32_t want = atomic_load(&slot->want);
+        if (want == 0 || want == slot->ready.key) continue;
+
+        HintTurn *e = &cache[(want * 2654435761u) >> (32 - HINT_CACHE_BITS)];
+        if (e->key != want) {
+            uint32_t index = want - 1;
+            SolverState s = {
+                .used = (uint16_t)(index >> 7),
+                .upper = (uint8_t)((index >> 1) & 63),
+                .yahtzee = (uint8_t)(index & 1),
+            };
+            solver_turn(t, &s, &e->turn);
+            e->key = want;
+        }
+
+        seqlock_write_begin(&slot->seq);
+        memcpy(&slot->ready, e, sizeof(HintTurn));
+        seqlock_write_end(&slot->seq);
+        filled++;
+    }
+    return filled;
+}
@@ -0,0 +1,41 @@
+#ifndef HINT_H
+#define HINT_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "solver.h"
+
+// Hint cache between player sessions and the server's hint worker.
+//
+// Each seat has a slot in shared memory. When a turn starts the session
+// posts the player's scorecard state in `want` and pokes the worker; the
+// worker evaluates that state's turn (solver_turn) off the game thread and
+// publishes it under the slot's seqlock. A hint request then only copies
+// the slot out and does table lookups, so it never stalls the turn. The
+// worker keeps its own per-state cache, so players in the same situation
+// (every first turn, for one) share one evaluation.
+
+typedef struct {
+    uint32_t key;                          // solver_state_index + 1, 0 = none
+    SolverTurn turn;
+} HintTurn;
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;     // seqlock over `ready`
+    _Atomic uint32_t want;                 // state key the session asked for
+    HintTurn ready;                        // last state the worker published
+} HintSlot;
+
+// Session: ask for the turn of state `s`, waking the worker on `signal`.
+void hint_request(HintSlot *slot, const SolverState *s, _Atomic uint32_t *signal);
+
+// Session: copy out the evaluated turn for `s`. Returns 1, or 0 if the
+// worker has not got to it yet.
+int hint_lookup(const HintSlot *slot, const SolverState *s, SolverTurn *out);
+
+// Worker: fill every slot whose wanted state is not published yet.
+// Returns how many were filled. Not thread-safe: one worker only.
+int hint_service(HintSlot *slots, int n, const StrategyTable *t);
+
+#endif
@@ -0,0 +1,147 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "journal.h"
+
+#define JOURNAL_RING_SLOTS 32768
+#define JOURNAL_LINGER_MS  10          // pause between light drains
+#define JOURNAL_BUF        65536            // bytes gathered into one write()
+
+static MpscRing *ring;                      // shared with forked sessions
+static int journal_fd = -1;
+static pthread_t writer_tid;
+static atomic_int stopping;
+
+static unsigned char wbuf[JOURNAL_BUF + JOURNAL_REC_MAX];
+static size_t wlen;
+
+static void flush_buf(void) {
+    size_t off = 0;
+    while (off < wlen) {
+        ssize_t n = write(journal_fd, wbuf + off, wlen - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;                  // disk trouble: drop rather than stall
+        off += (size_t)n;
+    }
+    wlen = 0;
+}
+
+static void append(const JournalHdr *h, const void *payload) {
+    memcpy(wbuf + wlen, h, sizeof(*h));
+    memcpy(wbuf + wlen + sizeof(*h), payload, h->len);
+    wlen += sizeof(*h) + h->len;
+    if (wlen >= JOURNAL_BUF) flush_buf();
+}
+
+// Move whatever the ring holds into the buffer, noting any drops: records
+// that found the ring full, and records whose session died mid-push
+static int drain(uint64_t *reported_drops) {
+    JournalRec rec;
+    int got = 0;
+    while (mpsc_ring_pop(ring, &rec, sizeof(rec)) >= (int)sizeof(JournalHdr)) {
+        append(&rec.h, rec.data);
+        got++;
+    }
+
+    uint64_t drops = mpsc_ring_overflows(ring) + mpsc_ring_abandoned(ring);
+    if (drops != *reported_drops) {
+        uint64_t lost = drops - *reported_drops;
+        JournalHdr h = {.type = JNL_LOST, .len = sizeof(lost)};
+        append(&h, &lost);
+        *reported_drops = drops;
+    }
+    return got;
+}
+
+static void *journal_writer_thread(void *arg) {
+    (void)arg;
+    uint64_t reported_drops = 0;
+
+    // Producers only make a system call when this thread is asleep on the
+    // ring, and every wakeup costs a write(). So after a light drain the
+    // writer lingers (not waiting on the ring) and lets records pile up;
+    // a crash loses at most about JOURNAL_LINGER_MS of them. A drain of a
+    // quarter ring or more goes straight round again.
+    const struct timespec linger = {0, JOURNAL_LINGER_MS * 1000000L};
+    while (!atomic_load(&stopping)) {
+        if (!mpsc_ring_wait(ring, 200)) continue;
+        int got = drain(&reported_drops);
+        flush_buf();
+        if (got < JOURNAL_RING_SLOTS / 4) nanosleep(&linger, NULL);
+    }
+    drain(&reported_drops);
+    flush_buf();
+    return NULL;
+}
+
+int journal_open(const char *path, uint64_t run_seed) {
+    size_t size = mpsc_ring_size(JOURNAL_RING_SLOTS, sizeof(JournalRec));
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return -1;
+
+    journal_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (journal_fd < 0) {
+        munmap(mem, size);
+        return -1;
+    }
+
+    struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t pad;
+        uint64_t run_seed;
+        int64_t  started;
+    } run = {JOURNAL_MAGIC, JOURNAL_VERSION, 0, run_seed, (int64_t)time(NULL)};
+    JournalHdr h = {.type = JNL_RUN, .len = sizeof(run)};
+    append(&h, &run);
+    flush_buf();
+
+    mpsc_ring_init((MpscRing*)mem, JOURNAL_RING_SLOTS, sizeof(JournalRec));
+    atomic_store(&stopping, 0);
+    ring = (MpscRing*)mem;
+    if (pthread_create(&writer_tid, NULL, journal_writer_thread, NULL) != 0) {
+        ring = NULL;
+        close(journal_fd);
+        journal_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void journal_push(int type, int lobby, uint32_t match, int seat, const void *payload, size_t len) {
+    if (!ring) return;
+    if (len > sizeof(((JournalRec*)0)->data)) len = sizeof(((JournalRec*)0)->data);
+
+    JournalRec rec;
+    rec.h.type = (uint8_t)type;
+    rec.h.seat = (uint8_t)seat;
+    rec.h.lobby = (uint8_t)lobby;
+    rec.h.len = (uint8_t)len;
+    rec.h.match = match;
+    memcpy(rec.data, payload, len);
+    mpsc_ring_push(ring, &rec, sizeof(JournalHdr) + len);
+}
+
+void journal_close(void) {
+    if (!ring) return;
+    atomic_store(&stopping, 1);
+    pthread_join(writer_tid, NULL);
+    close(journal_fd);
+    journal_fd = -1;
+    ring = NULL;
+}
+
+const unsigned char *journal_next(const unsigned char **p, const unsigned char *end, JournalHdr *h) {
+    if ((size_t)(end - *p) < sizeof(*h)) return NULL;
+    memcpy(h, *p, sizeof(*h));
+    if ((size_t)(end - *p) < sizeof(*h) + h->len) return NULL;
+    const unsigned char *payload = *p + sizeof(*h);
+    *p = payload + h->len;
+    return payload;
+}
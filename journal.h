@@ -0,0 +1,88 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mpsc.h"
+
+// Append-only binary match journal.
+//
+// Every record is an 8-byte header and a short payload. Sessions,
+// schedulers and the parent push records into an MPSC ring in shared
+// memory (never blocking, like the game log). One writer thread in the
+// server drains the ring and appends the records in 64 KB writes. If the
+// ring fills up, or a session dies halfway through pushing a record, the
+// record is dropped and counted, and the writer appends a JNL_LOST record
+// so that a reader knows the affected matches are incomplete.
+//
+// A match is identified by its number within a run (the n of
+// rng_match_seed). Each server start appends a JNL_RUN record, which
+// begins a new numbering. A match restored by `server --resume` is
+// reopened in the new run under its old number by JNL_RESUME, followed by
+// one JNL_SEAT per participant with the scorecard it resumes from.
+// Records of matches in different lobbies interleave in the file.
+//
+// Multi-byte fields are little-endian as the server writes them; the
+// journal is read on the machine that wrote it.
+
+#define JOURNAL_MAGIC   0x4c4e4a59u         // "YJNL"
+#define JOURNAL_VERSION 2                   // 2 added JNL_RESUME and JNL_SEAT
+#define JOURNAL_REC_MAX 64                  // header + largest payload
+
+typedef enum {
+    JNL_RUN = 1,        // u32 magic, u16 version, u16 pad, u64 run seed, i64 start time
+    JNL_START,          // u64 match seed, u8 participant mask
+    JNL_JOIN,           // u8 bot level (0 = human), name (rest of the payload)
+    JNL_ROLL,           // u8 dice[5]: the turn's first roll
+    JNL_REROLL,         // u8 count, u8 pos[5] in draw order, u8 dice[5] after
+    JNL_STAND,          // the final dice were scored (Yahtzee rules ran)
+    JNL_SCORE,          // u8 category, u8 auto (Joker fill), i16 points
+    JNL_TIMEOUT,        // i8 category zeroed (-1 = none open)
+    JNL_DISCONNECT,     // every open category zeroed
+    JNL_END,            // i16 final[JOURNAL_SEATS], i8 winner
+    JNL_LOST,           // u64 records dropped since the last JNL_LOST
+    JNL_RESUME,         // u64 match seed, u8 participant mask: a match restored
+                        // from a checkpoint (server --resume) carries on
+    JNL_SEAT            // after JNL_RESUME, per participant: u32 dice drawn,
+                        // u16 filled categories, i16 Yahtzee bonus, u8 Joker
+                        // rules on, u8 Yahtzees, i8 required upper row,
+                        // i16 score[13]
+} JournalType;
+
+#define JOURNAL_SEATS 5
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  seat;
+    uint8_t  lobby;
+    uint8_t  len;                           // payload bytes after the header
+    uint32_t match;
+} JournalHdr;
+
+typedef struct {
+    JournalHdr h;
+    unsigned char data[JOURNAL_REC_MAX - sizeof(JournalHdr)];
+} JournalRec;
+
+// Writer side (server)
+
+// Map the ring, open (creating or appending to) `path`, write a JNL_RUN
+// record and start the writer thread. Call before forking any session.
+// Returns 0, or -1 with errno set.
+int journal_open(const char *path, uint64_t run_seed);
+
+// Any process or thread, never blocks; a no-op while no journal is open
+void journal_push(int type, int lobby, uint32_t match, int seat, const void *payload, size_t len);
+
+// Write out everything pushed so far, stop the writer and close the file
+void journal_close(void);
+
+// Reader side
+
+// Next record of a journal mapped at [p, end): copies its header to `h`
+// (records are not aligned), advances *p and returns the payload, or
+// NULL at the end or at a truncated tail
+const unsigned char *journal_next(const unsigned char **p, const unsigned char *end, JournalHdr *h);
+
+#endif
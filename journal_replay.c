@@ -0,0 +1,353 @@
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "rng.h"
+#include "scoring.h"
+
+// Replays a match journal and checks it against the rules.
+//
+// The journal is mapped read-only and walked once. Every match is
+// re-run from its seed: each roll and reroll is drawn again from the
+// seat's stream and must give the recorded dice. At the end of each
+// turn the score table and the server's Yahtzee bonus, forced-Joker and
+// upper bonus rules are applied, and every recorded score, timeout zero
+// and final total must come out the same. A match whose records were
+// dropped (JNL_LOST) or that never finished (the server stopped) is
+// counted as incomplete, not as a divergence. A match restored after a
+// server crash (JNL_RESUME) is checked from the scorecards it was restored
+// with, its dice streams wound forward past the dice already drawn.
+//
+//   journal_replay [-v] [FILE]      (default matches.jnl)
+//
+// Exits 1 if any match diverged.
+
+#define MAX_SHOWN 10                        // divergences printed in full
+#define MAX_LIVE  256                       // matches in flight at once
+
+typedef struct {
+    Rng rng;
+    int dice[5];
+    int points[SCORING_NUM_CATEGORIES];     // offered for the last stand
+    int score[SCORING_NUM_CATEGORIES];
+    int used;                               // bit mask of filled categories
+    int achieved;                           // Yahtzee scored as 50: Joker rules on
+    int yahtzees;                           // Yahtzees rolled and scored on
+    int required;                           // upper row a further Yahtzee is forced into
+    int yahtzee_bonus;
+    int autofill;                           // category the rules filled this turn, -1 = none
+} Seat;
+
+typedef struct {
+    uint32_t match;
+    int lobby;
+    int mask;                               // participants
+    int diverged;
+    Seat seat[JOURNAL_SEATS];
+} Match;
+
+typedef struct {
+    int verbose;
+    int run;                                // JNL_RUN records seen
+    long records, orphans;
+    long verified, diverged, incomplete, resumed;
+    int live_count;
+    Match *live[MAX_LIVE];
+} Replay;
+
+static void diverge(Replay *r, Match *m, int seat, const char *fmt, ...) {
+    if (m->diverged) return;
+    m->diverged = 1;
+    r->diverged++;
+    if (r->diverged > MAX_SHOWN && !r->verbose) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    printf("  run %d match %u (lobby %d) seat %d: ", r->run, m->match, m->lobby + 1, seat + 1);
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+}
+
+static Match *find_live(Replay *r, uint32_t match, int *slot) {
+    for (int i = 0; i < r->live_count; i++) {
+        if (r->live[i]->match == match) {
+            if (slot) *slot = i;
+            return r->live[i];
+        }
+    }
+    return NULL;
+}
+
+static void drop_live(Replay *r, int slot) {
+    free(r->live[slot]);
+    r->live[slot] = r->live[--r->live_count];
+}
+
+// Matches still open when the run ends or records go missing
+static void abandon_live(Replay *r) {
+    while (r->live_count > 0) {
+        if (!r->live[0]->diverged) r->incomplete++;
+        drop_live(r, 0);
+    }
+}
+
+static int upper_total(const Seat *s) {
+    int t = 0;
+    for (int c = 0; c < 6; c++) t += s->score[c];
+    return t;
+}
+
+static void fill(Seat *s, int cat, int points) {
+    s->score[cat] = points;
+    s->used |= 1 << cat;
+}
+
+// What session_begin_scoring does to the final dice
+static void stand(Seat *s) {
+    scoring_possible_scores(scoring_roll_index(s->dice), s->achieved, s->points);
+    s->autofill = -1;
+    if (s->points[CAT_YAHTZEE] != 50) return;
+
+    s->required = s->dice[0] - 1;
+    if (s->yahtzees == 0) {
+        s->yahtzees = 1;
+        return;
+    }
+    s->yahtzees++;
+    if (!s->achieved) return;
+
+    s->yahtzee_bonus += 100;
+    if ((s->used & (1 << CAT_YAHTZEE)) && !(s->used & (1 << s->required))) {
+        s->autofill = s->required;
+        fill(s, s->required, s->points[s->required]);
+    }
+}
+
+static void check_dice(Replay *r, Match *m, int seat, const unsigned char *rec) {
+    Seat *s = &m->seat[seat];
+    for (int i = 0; i < 5; i++) {
+        if (s->dice[i] != rec[i]) {
+            diverge(r, m, seat, "dice %d%d%d%d%d, seed gives %d%d%d%d%d",
+                    rec[0], rec[1], rec[2], rec[3], rec[4],
+                    s->dice[0], s->dice[1], s->dice[2], s->dice[3], s->dice[4]);
+            return;
+        }
+    }
+}
+
+static void end_match(Replay *r, Match *m, const unsigned char *rec) {
+    int best = -1, best_total = -1;
+    for (int p = 0; p < JOURNAL_SEATS; p++) {
+        if (!(m->mask & (1 << p))) continue;
+        const Seat *s = &m->seat[p];
+        int total = s->yahtzee_bonus + (upper_total(s) >= 63 ? 35 : 0);
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) total += s->score[c];
+
+        int16_t logged;
+        memcpy(&logged, rec + 2 * p, 2);
+        if (logged != total) diverge(r, m, p, "final score %d, replay gives %d", logged, total);
+        if (total > best_total) { best_total = total; best = p; }
+    }
+    int winner = (signed char)rec[2 * JOURNAL_SEATS];
+    if (winner != best) diverge(r, m, winner, "winner is seat %d, replay gives seat %d", winner + 1, best + 1);
+    if (!m->diverged) r->verified++;
+}
+
+static void replay_record(Replay *r, const JournalHdr *h, const unsigned char *d) {
+    r->records++;
+
+    if (h->type == JNL_RUN) {
+        abandon_live(r);
+        r->run++;
+        return;
+    }
+    if (h->type == JNL_LOST) {
+        abandon_live(r);
+        return;
+    }
+
+    int slot = 0;
+    Match *m = find_live(r, h->match, &slot);
+    if (h->type == JNL_START || h->type == JNL_RESUME) {
+        if (h->len < 9 || m || r->live_count == MAX_LIVE) { r->orphans++; return; }
+        if (h->type == JNL_RESUME) r->resumed++;
+        m = (Match*)calloc(1, sizeof(Match));
+        if (!m) { perror("calloc"); exit(1); }
+        uint64_t seed;
+        memcpy(&seed, d, 8);
+        m->match = h->match;
+        m->lobby = h->lobby;
+        m->mask = d[8];
+        Rng streams[JOURNAL_SEATS];
+        rng_seed_match(streams, JOURNAL_SEATS, seed);
+        for (int p = 0; p < JOURNAL_SEATS; p++) m->seat[p].rng = streams[p];
+        r->live[r->live_count++] = m;
+        return;
+    }
+    if (!m || h->seat >= JOURNAL_SEATS) { r->orphans++; return; }
+
+    int p = h->seat;
+    Seat *s = &m->seat[p];
+    switch (h->type) {
+    case JNL_JOIN:
+        break;
+    case JNL_SEAT: {
+        if (h->len < 37) break;
+        uint32_t draws;
+        uint16_t used;
+        int16_t bonus, pts;
+        memcpy(&draws, d, 4);
+        memcpy(&used, d + 4, 2);
+        memcpy(&bonus, d + 6, 2);
+        for (uint32_t i = 0; i < draws; i++) rng_next(&s->rng);
+        s->used = used;
+        s->yahtzee_bonus = bonus;
+        s->achieved = d[8];
+        s->yahtzees = d[9];
+        s->required = (signed char)d[10];
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) {
+            memcpy(&pts, d + 11 + 2 * c, 2);
+            s->score[c] = pts;
+        }
+        break;
+    }
+    case JNL_ROLL:
+        if (h->len < 5) break;
+        for (int i = 0; i < 5; i++) s->dice[i] = rng_die(&s->rng);
+        check_dice(r, m, p, d);
+        break;
+    case JNL_REROLL:
+        if (h->len < 11) break;
+        for (int i = 0; i < d[0] && i < 5; i++) s->dice[d[1 + i] % 5] = rng_die(&s->rng);
+        check_dice(r, m, p, d + 6);
+        break;
+    case JNL_STAND:
+        stand(s);
+        break;
+    case JNL_SCORE: {
+        if (h->len < 4) break;
+        int cat = d[0];
+        int16_t pts;
+        memcpy(&pts, d + 2, 2);
+        if (cat >= SCORING_NUM_CATEGORIES) {
+            diverge(r, m, p, "category %d out of range", cat + 1);
+        } else if (d[1]) {
+            if (s->autofill != cat || s->score[cat] != pts)
+                diverge(r, m, p, "Joker filled %s with %d, rules give %s",
+                        scoring_category_name(cat), pts,
+                        s->autofill < 0 ? "no fill" : scoring_category_name(s->autofill));
+        } else if (s->used & (1 << cat)) {
+            diverge(r, m, p, "%s scored twice", scoring_category_name(cat));
+        } else {
+            if (s->points[cat] != pts)
+                diverge(r, m, p, "%d in %s, rules give %d", pts, scoring_category_name(cat), s->points[cat]);
+            fill(s, cat, s->points[cat]);
+            if (cat == CAT_YAHTZEE && s->points[cat] == 50) s->achieved = 1;
+        }
+        break;
+    }
+    case JNL_TIMEOUT: {
+        if (h->len < 1) break;
+        int want = -1;
+        for (int c = 0; c < SCORING_NUM_CATEGORIES && want < 0; c++) if (!(s->used & (1 << c))) want = c;
+        int got = (signed char)d[0];
+        if (got != want) diverge(r, m, p, "timeout zeroed category %d, next open is %d", got + 1, want + 1);
+        if (want >= 0) fill(s, want, 0);
+        break;
+    }
+    case JNL_DISCONNECT:
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) if (!(s->used & (1 << c))) fill(s, c, 0);
+        break;
+    case JNL_END:
+        if (h->len >= 2 * JOURNAL_SEATS + 1) end_match(r, m, d);
+        else r->incomplete++;
+        drop_live(r, slot);
+        break;
+    default:
+        r->orphans++;
+        break;
+    }
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    Replay r;
+    memset(&r, 0, sizeof(r));
+    const char *path = "matches.jnl";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) r.verbose = 1;
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-v] [FILE]\n", argv[0]);
+            return 2;
+        } else path = argv[i];
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(path);
+        return 2;
+    }
+    if (st.st_size == 0) {
+        printf("%s is empty\n", path);
+        return 0;
+    }
+    const unsigned char *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    madvise((void*)base, (size_t)st.st_size, MADV_SEQUENTIAL);
+    scoring_init();
+
+    JournalHdr h;
+    const unsigned char *p = base, *end = base + st.st_size, *d;
+    if (!(d = journal_next(&p, end, &h)) || h.type != JNL_RUN || h.len < 6) {
+        fprintf(stderr, "%s: not a match journal\n", path);
+        return 2;
+    }
+    uint32_t magic;
+    uint16_t version;
+    memcpy(&magic, d, 4);
+    memcpy(&version, d + 4, 2);
+    if (magic != JOURNAL_MAGIC || version < 1 || version > JOURNAL_VERSION) {
+        fprintf(stderr, "%s: unsupported journal (magic %08x, version %u)\n", path, magic, version);
+        return 2;
+    }
+
+    double t0 = now_sec();
+    p = base;
+    while ((d = journal_next(&p, end, &h))) replay_record(&r, &h, d);
+    long open_matches = r.live_count;
+    abandon_live(&r);
+    double dt = now_sec() - t0;
+    if (dt <= 0) dt = 1e-9;
+
+    long matches = r.verified + r.diverged + r.incomplete;
+    printf("%s: %d run%s, %ld records (%.1f MB) in %.3f s, %.0f matches/s\n",
+           path, r.run, r.run == 1 ? "" : "s", r.records, st.st_size / 1e6, dt, matches / dt);
+    printf("  verified    %ld\n", r.verified);
+    printf("  diverged    %ld\n", r.diverged);
+    printf("  incomplete  %ld (records dropped, or the server stopped mid-match; %ld at end of file)\n",
+           r.incomplete, open_matches);
+    if (r.resumed) printf("  resumed     %ld (restored from a checkpoint, checked from there on)\n", r.resumed);
+    if (r.orphans) printf("  %ld records of matches whose start is missing\n", r.orphans);
+    if (p != end) printf("  %ld bytes of a truncated record at the end\n", (long)(end - p));
+
+    munmap((void*)base, (size_t)st.st_size);
+    return r.diverged ? 1 : 0;
+}
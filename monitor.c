@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "snapshot.h"
+
+// Read-only live view of every lobby. Maps the server's snapshot object
+// PROT_READ and copies sections out with seqlock_read, so it never takes a
+// game lock and can be run any number of times alongside the server.
+
+#define DEFAULT_INTERVAL_MS 500
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--lobby N] [--interval MS] [--once]\n", prog);
+}
+
+static const char *lobby_status(const SnapMatch *m) {
+    if (m->game_finished) return "FINISHED";
+    if (m->game_started)  return "IN PROGRESS";
+    if (m->active_players > 0) return "FILLING";
+    return "IDLE";
+}
+
+static void render_lobby(int lobby, const SnapMatch *m, const SnapPlayer *players) {
+    printf("Lobby %d  [%s]  players %d/%d", lobby + 1, lobby_status(m),
+           m->active_players, m->target_players);
+    if (m->turn_owner >= 0) {
+        printf("  turn: Player %d (%s)", m->turn_owner + 1, m->seats[m->turn_owner].name);
+    }
+    printf("\n");
+
+    if (!m->game_started) {
+        for (int p = 0; p < SNAP_MAX_PLAYERS; p++) {
+            if (m->seats[p].connected) printf("  %d. %s (waiting)\n", p + 1, m->seats[p].name);
+        }
+        return;
+    }
+
+    printf("  %-2s %-16s %-21s %-7s %5s %5s %5s\n",
+           "#", "Name", "Dice", "Rerolls", "Upper", "Lower", "Total");
+    for (int p = 0; p < SNAP_MAX_PLAYERS; p++) {
+        if (!m->seats[p].participant) continue;
+        const SnapPlayer *sp = &players[p];
+
+        int upper = 0, lower = 0, filled = 0;
+        for (int i = 0; i < 6; i++)  upper += sp->score[i];
+        for (int i = 6; i < 13; i++) lower += sp->score[i];
+        for (int i = 0; i < 13; i++) filled += sp->scored[i];
+
+        // Dice only mean something for the player whose turn is running
+        char dice[32] = "", rerolls[8] = "";
+        if (p == m->turn_owner) {
+            snprintf(dice, sizeof(dice), "[%d][%d][%d][%d][%d]",
+                     sp->dice[0], sp->dice[1], sp->dice[2], sp->dice[3], sp->dice[4]);
+            snprintf(rerolls, sizeof(rerolls), "%d", sp->rerolls_left);
+        }
+
+        printf("  %-2d %-16.16s %-21s %-7s %5d %5d %5d  %2d/13%s%s\n",
+               p + 1, m->seats[p].name, dice, rerolls,
+               upper, lower, sp->total, filled,
+               m->seats[p].connected ? "" : "  (left)",
+               (m->game_finished && p == m->winner_id) ? "  WINNER" : "");
+    }
+}
+
+static void render_leaders(const SnapLeaders *sl) {
+    printf("Leaderboard  (%u players on file)\n", sl->players);
+    if (sl->count == 0) {
+        printf("  no finished games yet\n");
+        return;
+    }
+    printf("  %-3s %-16s %5s %6s %7s %5s\n", "#", "Name", "Wins", "Games", "Avg", "High");
+    for (int i = 0; i < sl->count; i++) {
+        const SnapLeader *e = &sl->top[i];
+        printf("  %-3d %-16.16s %5u %6u %7.1f %5u\n", i + 1, e->name, e->wins, e->games,
+               e->games ? (double)e->total_score / e->games : 0.0, e->high_score);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int only_lobby = -1;
+    int interval_ms = DEFAULT_INTERVAL_MS;
+    int once = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lobby") == 0 && i + 1 < argc) {
+            only_lobby = atoi(argv[++i]) - 1;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--once") == 0) {
+            once = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (interval_ms < 10) interval_ms = 10;
+
+    size_t size;
+    const SnapshotArena *snap = snapshot_attach(&size);
+    if (!snap) {
+        perror("Cannot open game snapshots (is the server running?)");
+        return 1;
+    }
+
+    int n = snap->num_lobbies;
+    if (only_lobby >= n) {
+        fprintf(stderr, "Server only hosts %d lobbies\n", n);
+        return 1;
+    }
+
+    int tty = isatty(STDOUT_FILENO);
+    uint32_t *last = (uint32_t*)calloc((size_t)n * (SNAP_MAX_PLAYERS + 1), sizeof(uint32_t));
+    if (!last) {
+        perror("calloc");
+        return 1;
+    }
+    uint32_t last_leaders = 0;
+    int first = 1;
+
+    while (1) {
+        SnapMatch match[n];
+        SnapPlayer players[n][SNAP_MAX_PLAYERS];
+        SnapLeaders leaders;
+        int changed = first;
+
+        uint32_t lv = seqlock_read(&snap->leaders.seq, &leaders, &snap->leaders, sizeof(SnapLeaders));
+        if (lv != last_leaders) changed = 1;
+        last_leaders = lv;
+
+        for (int l = 0; l < n; l++) {
+            if (only_lobby >= 0 && l != only_lobby) continue;
+            const LobbySnapshot *ls = &snap->lobbies[l];
+            uint32_t *ver = &last[(size_t)l * (SNAP_MAX_PLAYERS + 1)];
+
+            uint32_t v = seqlock_read(&ls->match.seq, &match[l], &ls->match, sizeof(SnapMatch));
+            if (v != ver[0]) changed = 1;
+            ver[0] = v;
+
+            for (int p = 0; p < SNAP_MAX_PLAYERS; p++) {
+                v = seqlock_read(&ls->players[p].seq, &players[l][p], &ls->players[p],
+                                 sizeof(SnapPlayer));
+                if (v != ver[p + 1]) changed = 1;
+                ver[p + 1] = v;
+            }
+        }
+
+        if (changed) {
+            if (tty && !once) printf("\033[H\033[J");
+            time_t now = time(NULL);
+            char ts[32];
+            strftime(ts, sizeof(ts), "%H:%M:%S", localtime(&now));
+            printf("=== YAHTZEE MONITOR (%s) ===\n\n", ts);
+
+            for (int l = 0; l < n; l++) {
+                if (only_lobby >= 0 && l != only_lobby) continue;
+                render_lobby(l, &match[l], players[l]);
+                printf("\n");
+            }
+            render_leaders(&leaders);
+            fflush(stdout);
+        }
+
+        if (once) break;
+        first = 0;
+
+        struct timespec ts = { interval_ms / 1000, (long)(interval_ms % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+
+    free(last);
+    munmap((void*)snap, size);
+    return 0;
+}
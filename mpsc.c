@@ -0,0 +1,202 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+#include "futex.h"
+#include "mpsc.h"
+
+// Our pid, stamped into every claimed slot; kept current across fork so a
+// push never needs a system call
+static pid_t self_pid;
+
+static void refresh_pid(void) {
+    self_pid = getpid();
+}
+
+static uint32_t round_pow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static size_t slot_stride(uint32_t slot_size) {
+    size_t s = sizeof(MpscSlot) + slot_size;
+    return (s + 7) & ~(size_t)7;
+}
+
+static MpscSlot *slot_at(MpscRing *r, uint32_t pos) {
+    return (MpscSlot*)(r->slots + (size_t)(pos & (r->capacity - 1)) * slot_stride(r->slot_size));
+}
+
+size_t mpsc_ring_size(uint32_t capacity, uint32_t slot_size) {
+    return sizeof(MpscRing) + (size_t)round_pow2(capacity) * slot_stride(slot_size);
+}
+
+void mpsc_ring_init(MpscRing *r, uint32_t capacity, uint32_t slot_size) {
+    r->capacity = round_pow2(capacity);
+    r->slot_size = slot_size;
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+    atomic_store(&r->consumer_waiting, 0);
+    atomic_store(&r->signal, 0);
+    atomic_store(&r->overflows, 0);
+    atomic_store(&r->abandoned, 0);
+    r->stall_pos = 0;
+    r->stall_since_ms = -1;
+
+    if (!self_pid) {
+        refresh_pid();
+        pthread_atfork(NULL, NULL, refresh_pid);
+    }
+
+    // Slot i is free for the producer that claims position i
+    for (uint32_t i = 0; i < r->capacity; i++) {
+        atomic_store_explicit(&slot_at(r, i)->seq, i, memory_order_relaxed);
+        atomic_store_explicit(&slot_at(r, i)->owner, 0, memory_order_relaxed);
+    }
+}
+
+int mpsc_ring_push(MpscRing *r, const void *data, size_t len) {
+    uint32_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    MpscSlot *slot;
+
+    while (1) {
+        slot = slot_at(r, pos);
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t dif = (int32_t)(seq - pos);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                atomic_store_explicit(&slot->owner, self_pid, memory_order_relaxed);
+                break;
+            }
+        } else if (dif < 0) {
+            // The consumer has not freed this slot yet: the ring is full
+            atomic_fetch_add_explicit(&r->overflows, 1, memory_order_relaxed);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+
+    if (len > r->slot_size) len = r->slot_size;
+    memcpy(slot->data, data, len);
+    slot->len = (uint32_t)len;
+
+    // Fails only if the consumer already gave up on us (see mpsc_ring_pop)
+    uint32_t expected = pos;
+    if (!atomic_compare_exchange_strong_explicit(&slot->seq, &expected, pos + 1,
+                                                 memory_order_release,
+                                                 memory_order_relaxed)) {
+        return -1;
+    }
+
+    // Pairs with the consumer's store to consumer_waiting before it re-checks
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&r->consumer_waiting)) {
+        atomic_fetch_add(&r->signal, 1);
+        futex_wake(&r->signal, 1);
+    }
+    return 0;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Has the producer that claimed the unpublished slot at `pos` died?
+static int claim_abandoned(MpscRing *r, MpscSlot *slot, uint32_t pos) {
+    pid_t owner = atomic_load_explicit(&slot->owner, memory_order_relaxed);
+    if (owner != 0) {
+        r->stall_since_ms = -1;
+        return kill(owner, 0) == -1 && errno == ESRCH;
+    }
+
+    // Died between the claim and stamping its pid (or is very slow there)
+    int64_t now = now_ms();
+    if (r->stall_since_ms < 0 || r->stall_pos != pos) {
+        r->stall_pos = pos;
+        r->stall_since_ms = now;
+        return 0;
+    }
+    return now - r->stall_since_ms >= MPSC_STALL_MS;
+}
+
+int mpsc_ring_pop(MpscRing *r, void *out, size_t cap) {
+    while (1) {
+        uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        MpscSlot *slot = slot_at(r, pos);
+
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != pos + 1) {
+            // Empty, or claimed and still being written
+            if (atomic_load_explicit(&r->head, memory_order_relaxed) == pos ||
+                !claim_abandoned(r, slot, pos)) {
+                return -1;
+            }
+
+            // Take the slot back unless it got published after all
+            uint32_t expected = pos;
+            if (!atomic_compare_exchange_strong_explicit(&slot->seq, &expected, pos + r->capacity,
+                                                         memory_order_acq_rel,
+                                                         memory_order_acquire)) {
+                continue;
+            }
+            atomic_store_explicit(&slot->owner, 0, memory_order_relaxed);
+            atomic_store_explicit(&r->tail, pos + 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&r->abandoned, 1, memory_order_relaxed);
+            r->stall_since_ms = -1;
+            continue;
+        }
+
+        size_t len = slot->len;
+        if (len > cap) len = cap;
+        memcpy(out, slot->data, len);
+
+        // Hand the slot back to producers one lap ahead
+        atomic_store_explicit(&slot->owner, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->seq, pos + r->capacity, memory_order_release);
+        atomic_store_explicit(&r->tail, pos + 1, memory_order_relaxed);
+        return (int)len;
+    }
+}
+
+static int mpsc_ring_ready(MpscRing *r) {
+    uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    return atomic_load_explicit(&slot_at(r, pos)->seq, memory_order_acquire) == pos + 1;
+}
+
+// A slot has been claimed but the next one to read is not published yet
+static int mpsc_ring_pending(MpscRing *r) {
+    return atomic_load_explicit(&r->head, memory_order_relaxed) !=
+           atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+int mpsc_ring_wait(MpscRing *r, int timeout_ms) {
+    if (mpsc_ring_ready(r)) return 1;
+
+    // Nothing wakes us for a producer that died mid-record: come back to it
+    int pending = mpsc_ring_pending(r);
+    if (pending && (timeout_ms < 0 || timeout_ms > MPSC_STALL_POLL_MS)) timeout_ms = MPSC_STALL_POLL_MS;
+
+    uint32_t sig = atomic_load(&r->signal);
+    atomic_store(&r->consumer_waiting, 1);
+    if (!mpsc_ring_ready(r)) futex_wait(&r->signal, sig, timeout_ms);
+    atomic_store(&r->consumer_waiting, 0);
+
+    return mpsc_ring_ready(r) || pending;
+}
+
+uint64_t mpsc_ring_overflows(const MpscRing *r) {
+    return atomic_load_explicit((_Atomic uint64_t*)&r->overflows, memory_order_relaxed);
+}
+
+uint64_t mpsc_ring_abandoned(const MpscRing *r) {
+    return atomic_load_explicit((_Atomic uint64_t*)&r->abandoned, memory_order_relaxed);
+}
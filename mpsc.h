@@ -0,0 +1,74 @@
+#ifndef MPSC_H
+#define MPSC_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded lock-free multi-producer / single-consumer ring of fixed-size
+// records, meant to live in memory shared by several processes.
+//
+// Producers claim a slot with one CAS on `head`, copy their record in and
+// publish it through the slot's sequence number; no producer ever takes a
+// lock or waits for another. When the ring is full the record is dropped
+// and counted instead of waiting. The single consumer reads slots in order
+// and only sleeps (futex) when the ring is empty; producers issue a wakeup
+// only if it is actually asleep.
+//
+// Producers may be forked processes that die at any moment. A producer
+// that dies after claiming a slot but before publishing it would leave the
+// consumer stuck at that slot for good, so each slot records its claimer's
+// pid. The consumer skips an unpublished slot once that process is gone,
+// or once it has stayed unpublished for MPSC_STALL_MS when the claimer
+// died before recording its pid, and counts the record as abandoned. A
+// live claimer is always waited for (a recycled pid looks alive too).
+
+#define MPSC_STALL_MS      1000            // give up on an unowned claimed slot
+#define MPSC_STALL_POLL_MS 100             // how often a waiting consumer rechecks one
+
+typedef struct {
+    _Atomic uint32_t seq;
+    uint32_t len;
+    _Atomic int32_t owner;                 // pid of the claiming producer, 0 = not known yet
+    uint32_t pad;
+    char data[];
+} MpscSlot;
+
+typedef struct {
+    uint32_t capacity;                     // number of slots, power of two
+    uint32_t slot_size;                    // payload bytes per slot
+    _Alignas(64) _Atomic uint32_t head;    // next slot to claim (producers)
+    _Alignas(64) _Atomic uint32_t tail;    // next slot to read (consumer)
+    uint32_t stall_pos;                    // consumer only: unowned slot being timed
+    int64_t stall_since_ms;
+    _Atomic uint32_t consumer_waiting;
+    _Atomic uint32_t signal;               // futex word bumped on wakeups
+    _Atomic uint64_t overflows;            // records dropped because the ring was full
+    _Atomic uint64_t abandoned;            // slots skipped because their producer died
+    _Alignas(64) char slots[];
+} MpscRing;
+
+// Bytes needed for a ring of `capacity` slots (rounded up to a power of two).
+size_t mpsc_ring_size(uint32_t capacity, uint32_t slot_size);
+
+void mpsc_ring_init(MpscRing *r, uint32_t capacity, uint32_t slot_size);
+
+// Append one record (truncated to slot_size). Never blocks.
+// Returns 0, or -1 if the ring was full and the record was dropped.
+int mpsc_ring_push(MpscRing *r, const void *data, size_t len);
+
+// Consumer: copy the next record into `out` (cap >= slot_size), skipping
+// slots abandoned by dead producers. Returns its length, or -1 if no
+// record is ready.
+int mpsc_ring_pop(MpscRing *r, void *out, size_t cap);
+
+// Consumer: sleep until a record is available. timeout_ms < 0 waits forever.
+// Returns 1 when there is something for mpsc_ring_pop to do, 0 on timeout.
+// While a claimed slot is still unpublished it returns at least every
+// MPSC_STALL_POLL_MS so that pop can skip the slot if its producer died.
+int mpsc_ring_wait(MpscRing *r, int timeout_ms);
+
+uint64_t mpsc_ring_overflows(const MpscRing *r);
+uint64_t mpsc_ring_abandoned(const MpscRing *r);
+
+#endif
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "protocol.h"
+
+// Frame builder
+
+void proto_begin(ProtoMsg *m, MsgType type) {
+    m->data[0] = (unsigned char)type;
+    m->data[1] = PROTO_VERSION;
+    m->data[2] = 0;
+    m->data[3] = 0;
+    m->len = PROTO_HEADER_SIZE;
+    m->overflow = 0;
+}
+
+void proto_put_bytes(ProtoMsg *m, const void *buf, size_t len) {
+    if (m->overflow || m->len + len > sizeof(m->data)) {
+        m->overflow = 1;
+        return;
+    }
+    memcpy(m->data + m->len, buf, len);
+    m->len += len;
+}
+
+void proto_put_u8(ProtoMsg *m, int v) {
+    unsigned char b = (unsigned char)v;
+    proto_put_bytes(m, &b, 1);
+}
+
+void proto_put_i16(ProtoMsg *m, int v) {
+    uint16_t u = (uint16_t)(int16_t)v;
+    unsigned char b[2] = { (unsigned char)(u & 0xff), (unsigned char)(u >> 8) };
+    proto_put_bytes(m, b, 2);
+}
+
+void proto_put_str(ProtoMsg *m, const char *s) {
+    proto_put_bytes(m, s, strlen(s) + 1);
+}
+
+size_t proto_end(ProtoMsg *m) {
+    if (m->overflow) return 0;
+    size_t payload = m->len - PROTO_HEADER_SIZE;
+    m->data[2] = (unsigned char)(payload & 0xff);
+    m->data[3] = (unsigned char)(payload >> 8);
+    return m->len;
+}
+
+
+// Incremental parser
+
+void proto_parser_init(ProtoParser *p) {
+    p->len = 0;
+    p->pos = 0;
+}
+
+size_t proto_parser_feed(ProtoParser *p, const void *data, size_t len) {
+    // Drop consumed frames before appending
+    if (p->pos > 0) {
+        memmove(p->buf, p->buf + p->pos, p->len - p->pos);
+        p->len -= p->pos;
+        p->pos = 0;
+    }
+
+    size_t room = sizeof(p->buf) - p->len;
+    if (len > room) len = room;
+    memcpy(p->buf + p->len, data, len);
+    p->len += len;
+    return len;
+}
+
+int proto_parser_next(ProtoParser *p, ProtoFrame *f) {
+    size_t avail = p->len - p->pos;
+    if (avail < PROTO_HEADER_SIZE) return 0;
+
+    const unsigned char *h = p->buf + p->pos;
+    size_t payload = (size_t)h[2] | ((size_t)h[3] << 8);
+    if (h[1] != PROTO_VERSION || payload > PROTO_MAX_PAYLOAD) return -1;
+    if (avail < PROTO_HEADER_SIZE + payload) return 0;
+
+    f->type = (MsgType)h[0];
+    f->payload = h + PROTO_HEADER_SIZE;
+    f->len = payload;
+    p->pos += PROTO_HEADER_SIZE + payload;
+    return 1;
+}
+
+
+// Payload reader
+
+void proto_reader_init(ProtoReader *r, const ProtoFrame *f) {
+    r->p = f->payload;
+    r->len = f->len;
+    r->pos = 0;
+    r->bad = 0;
+}
+
+int proto_get_u8(ProtoReader *r) {
+    if (r->pos + 1 > r->len) {
+        r->bad = 1;
+        return 0;
+    }
+    return r->p[r->pos++];
+}
+
+int proto_get_i8(ProtoReader *r) {
+    return (int)(signed char)proto_get_u8(r);
+}
+
+int proto_get_i16(ProtoReader *r) {
+    if (r->pos + 2 > r->len) {
+        r->bad = 1;
+        return 0;
+    }
+    uint16_t u = (uint16_t)(r->p[r->pos] | (r->p[r->pos + 1] << 8));
+    r->pos += 2;
+    return (int)(int16_t)u;
+}
+
+const char *proto_get_str(ProtoReader *r) {
+    const unsigned char *start = r->p + r->pos;
+    const unsigned char *nul = memchr(start, '\0', r->len - r->pos);
+    if (!nul) {
+        r->bad = 1;
+        r->pos = r->len;
+        return "";
+    }
+    r->pos += (size_t)(nul - start) + 1;
+    return (const char*)start;
+}
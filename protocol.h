@@ -0,0 +1,100 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Server -> client wire protocol.
+// Every message is a frame: a 4-byte header {type, version, length lo, length hi}
+// followed by `length` payload bytes. Multi-byte integers are little-endian.
+// The client never has to guess from text whether input is expected: it
+// answers exactly one line per MSG_PROMPT.
+
+#define PROTO_VERSION     1
+#define PROTO_HEADER_SIZE 4
+#define PROTO_MAX_PAYLOAD 4096
+#define PROTO_MAX_FRAME   (PROTO_HEADER_SIZE + PROTO_MAX_PAYLOAD)
+
+typedef enum {
+    MSG_HELLO = 1,      // u8 ring (1 = shm rings accepted, 0 = stay on FIFOs),
+                        // u8 rejoined (1 = the offered seat token was taken)
+    MSG_REJECT,         // str reason; the server hangs up afterwards
+    MSG_TEXT,           // raw text, shown as-is
+    MSG_PROMPT,         // u8 kind, u8 min, u8 max, u8 rerolls_left
+    MSG_DICE,           // u8 label, u8 dice[5]
+    MSG_OPTIONS,        // u8 count, count x {u8 category, i16 points}
+    MSG_SCORECARD,      // 13 x {i16 score, u8 scored}, u8 bonus, i16 upper_total, i16 yahtzee_bonus (-1 = none)
+    MSG_GAME_OVER,      // i16 my_score, i8 winner, u8 count, count x {u8 player, i16 score, str name}
+    MSG_SEAT,           // u8 lobby, u8 player, u8 token[8]: present the token
+                        // ("token=<16 hex digits>") to take the seat back
+    MSG_QUEUED          // i16 position (1 = next in), i16 waiting: sent in place
+                        // of MSG_HELLO, repeatedly, while every lobby is busy
+} MsgType;
+
+typedef enum {
+    PROMPT_NAME = 1,
+    PROMPT_PLAYERS,     // host picks the lobby size in [min, max]
+    PROMPT_REROLL,      // Y/N
+    PROMPT_WHICH_DICE,
+    PROMPT_CATEGORY,    // category number in [min, max]
+    PROMPT_BOTS         // host picks a bot level for the empty seats, 0 = none
+} PromptKind;
+
+typedef enum {
+    DICE_ROLLED = 1,
+    DICE_REROLLED
+} DiceLabel;
+
+// Frame builder. Puts past the end set `overflow` instead of writing.
+typedef struct {
+    unsigned char data[PROTO_MAX_FRAME];
+    size_t len;
+    int overflow;
+} ProtoMsg;
+
+void proto_begin(ProtoMsg *m, MsgType type);
+void proto_put_u8(ProtoMsg *m, int v);
+void proto_put_i16(ProtoMsg *m, int v);
+void proto_put_bytes(ProtoMsg *m, const void *buf, size_t len);
+void proto_put_str(ProtoMsg *m, const char *s);     // NUL-terminated on the wire
+
+// Patch the length into the header. Returns the frame size, or 0 on overflow.
+size_t proto_end(ProtoMsg *m);
+
+// Incremental frame parser: feed bytes as they arrive, pull whole frames out.
+typedef struct {
+    unsigned char buf[2 * PROTO_MAX_FRAME];
+    size_t len;
+    size_t pos;         // start of the next unparsed frame
+} ProtoParser;
+
+typedef struct {
+    MsgType type;
+    const unsigned char *payload;   // valid until the next proto_parser_feed
+    size_t len;
+} ProtoFrame;
+
+void proto_parser_init(ProtoParser *p);
+
+// Append up to `len` bytes; returns how many were taken (less only when
+// frames are waiting to be pulled).
+size_t proto_parser_feed(ProtoParser *p, const void *data, size_t len);
+
+// 1 = frame returned, 0 = need more bytes, -1 = malformed stream
+int proto_parser_next(ProtoParser *p, ProtoFrame *f);
+
+// Payload reader. Reads past the end return 0 / "" and set `bad`.
+typedef struct {
+    const unsigned char *p;
+    size_t len;
+    size_t pos;
+    int bad;
+} ProtoReader;
+
+void proto_reader_init(ProtoReader *r, const ProtoFrame *f);
+int proto_get_u8(ProtoReader *r);
+int proto_get_i8(ProtoReader *r);
+int proto_get_i16(ProtoReader *r);
+const char *proto_get_str(ProtoReader *r);
+
+#endif
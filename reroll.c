@@ -0,0 +1,135 @@
+#include <pthread.h>
+
+#include "reroll.h"
+
+#define COUNT_KEYS 46656                   // 6^6: counts of faces 1..6, base 6
+
+static short keep_of_counts[COUNT_KEYS];
+static short keep_start[REROLL_NUM_KEEPS + 1];
+static RerollOutcome outcomes[REROLL_NUM_TRANS];
+
+static short roll_hold_keep[SCORING_NUM_ROLLS][32];
+static short roll_keep_list[SCORING_NUM_ROLLS][32];
+static unsigned char roll_keep_count[SCORING_NUM_ROLLS];
+
+static int num_keeps;
+static int num_outcomes;
+static pthread_once_t reroll_once = PTHREAD_ONCE_INIT;
+
+static int counts_key(const int counts[7]) {
+    int key = 0;
+    for (int f = 6; f >= 1; f--) key = key * 6 + counts[f];
+    return key;
+}
+
+// Every multiset of `left` more faces from `face` up, with its multinomial weight
+static void add_outcomes(const int kept[7], int counts[7], int face, int left, double weight) {
+    if (face == 6) {
+        double w = weight;
+        for (int i = 2; i <= left; i++) w /= i;
+        counts[6] = left;
+
+        int dice[5], n = 0;
+        for (int f = 1; f <= 6; f++)
+            for (int c = 0; c < kept[f] + counts[f]; c++) dice[n++] = f;
+        outcomes[num_outcomes].roll = (unsigned char)scoring_roll_index(dice);
+        outcomes[num_outcomes].prob = w;
+        num_outcomes++;
+        counts[6] = 0;
+        return;
+    }
+    double w = weight;
+    for (int c = 0; c <= left; c++) {
+        if (c > 1) w /= c;
+        counts[face] = c;
+        add_outcomes(kept, counts, face + 1, left - c, w);
+    }
+    counts[face] = 0;
+}
+
+static void add_keeps(int counts[7], int face, int size) {
+    if (face > 6) {
+        int n = 0;
+        for (int f = 1; f <= 6; f++) n += counts[f];
+        if (n != size) return;
+
+        int k = num_keeps++;
+        keep_of_counts[counts_key(counts)] = (short)k;
+        keep_start[k] = (short)num_outcomes;
+
+        // (5-n)! / prod(c!) / 6^(5-n), with the 1/c! applied while enumerating
+        int left = 5 - n;
+        double weight = 1.0;
+        for (int i = 2; i <= left; i++) weight *= i;
+        for (int i = 0; i < left; i++) weight /= 6.0;
+
+        int more[7] = {0};
+        add_outcomes(counts, more, 1, left, weight);
+        return;
+    }
+    for (int c = 0; c <= 5; c++) {
+        counts[face] = c;
+        add_keeps(counts, face + 1, size);
+    }
+    counts[face] = 0;
+}
+
+static void build_tables(void) {
+    scoring_init();
+
+    // Keeps ordered by size, so index 0 is "reroll everything"
+    int counts[7] = {0};
+    for (int size = 0; size <= 5; size++) add_keeps(counts, 1, size);
+    keep_start[num_keeps] = (short)num_outcomes;
+
+    for (int r = 0; r < SCORING_NUM_ROLLS; r++) {
+        const unsigned char *d = scoring_roll_dice(r);
+        roll_keep_count[r] = 0;
+        for (int mask = 0; mask < 32; mask++) {
+            int kc[7] = {0};
+            for (int i = 0; i < 5; i++) if (mask & (1 << i)) kc[d[i]]++;
+            int k = keep_of_counts[counts_key(kc)];
+            roll_hold_keep[r][mask] = (short)k;
+
+            int seen = 0;
+            for (int j = 0; j < roll_keep_count[r]; j++) seen |= roll_keep_list[r][j] == k;
+            if (!seen) roll_keep_list[r][roll_keep_count[r]++] = (short)k;
+        }
+    }
+}
+
+void reroll_init(void) {
+    pthread_once(&reroll_once, build_tables);
+}
+
+int reroll_keep(int roll_index, int mask) {
+    return roll_hold_keep[roll_index][mask & 31];
+}
+
+int reroll_keep_of_dice(const int dice[5], int mask) {
+    int kc[7] = {0};
+    for (int i = 0; i < 5; i++) if (mask & (1 << i)) kc[dice[i]]++;
+    return keep_of_counts[counts_key(kc)];
+}
+
+const RerollOutcome *reroll_outcomes(int keep, int *count) {
+    *count = keep_start[keep + 1] - keep_start[keep];
+    return &outcomes[keep_start[keep]];
+}
+
+const short *reroll_roll_keeps(int roll_index, int *count) {
+    *count = roll_keep_count[roll_index];
+    return roll_keep_list[roll_index];
+}
+
+double reroll_expect(int keep, const double roll_ev[SCORING_NUM_ROLLS]) {
+    double e = 0.0;
+    for (int i = keep_start[keep]; i < keep_start[keep + 1]; i++) {
+        e += outcomes[i].prob * roll_ev[outcomes[i].roll];
+    }
+    return e;
+}
+
+void reroll_expect_all(const double roll_ev[SCORING_NUM_ROLLS], double keep_ev[REROLL_NUM_KEEPS]) {
+    for (int k = 0; k < REROLL_NUM_KEEPS; k++) keep_ev[k] = reroll_expect(k, roll_ev);
+}
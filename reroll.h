@@ -0,0 +1,48 @@
+#ifndef REROLL_H
+#define REROLL_H
+
+#include "scoring.h"
+
+// Precomputed reroll transitions.
+// Holding some dice of a roll and rerolling the rest leaves a "keep": a
+// multiset of 0..5 faces. There are only 462 keeps, and many (roll, hold
+// mask) pairs share one: holding either 3 of 3-3-3-5-6 is the same keep.
+// Each keep stores its sparse outcome distribution over the 252 sorted
+// rolls (4368 entries in total, at most 252 for one keep), so the
+// expectation of any per-roll quantity after a reroll is one short dot
+// product instead of Monte Carlo sampling.
+//
+// Hold masks are over the five dice as given: bit i set = keep dice[i].
+// For a roll index they refer to the sorted faces of scoring_roll_dice().
+
+#define REROLL_NUM_KEEPS  462
+#define REROLL_NUM_TRANS  4368
+#define REROLL_KEEP_NONE  0                // reroll all five dice
+#define REROLL_HOLD_ALL   31
+
+typedef struct {
+    unsigned char roll;                    // resulting sorted roll index
+    double prob;
+} RerollOutcome;
+
+// Build the tables. Safe to call more than once / from any thread.
+void reroll_init(void);
+
+// Keep left by holding `mask` of a sorted roll / of five dice in any order.
+int reroll_keep(int roll_index, int mask);
+int reroll_keep_of_dice(const int dice[5], int mask);
+
+// Outcome distribution of a keep; *count entries, probabilities sum to 1.
+const RerollOutcome *reroll_outcomes(int keep, int *count);
+
+// Distinct keeps reachable from a roll (holding all five last), so a
+// best-hold search never evaluates the same keep twice.
+const short *reroll_roll_keeps(int roll_index, int *count);
+
+// Expected roll_ev[] after rerolling everything but `keep`.
+double reroll_expect(int keep, const double roll_ev[SCORING_NUM_ROLLS]);
+
+// The same for every keep at once.
+void reroll_expect_all(const double roll_ev[SCORING_NUM_ROLLS], double keep_ev[REROLL_NUM_KEEPS]);
+
+#endif
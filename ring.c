@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "futex.h"
+#include "ring.h"
+
+static __thread unsigned long futex_calls;
+
+// Counted wrappers so sessions can report their I/O syscalls
+static long ring_futex_wait(_Atomic uint32_t *addr, uint32_t expected, int timeout_ms) {
+    futex_calls++;
+    return futex_wait(addr, expected, timeout_ms);
+}
+
+static void ring_futex_wake(_Atomic uint32_t *addr) {
+    futex_calls++;
+    futex_wake(addr, 1);
+}
+
+static void ring_init(SpscRing *r) {
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+    atomic_store(&r->reader_waiting, 0);
+    atomic_store(&r->writer_waiting, 0);
+    atomic_store(&r->closed, 0);
+}
+
+RingSegment* ring_segment_create(const char *name) {
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) return NULL;
+
+    if (ftruncate(fd, sizeof(RingSegment)) == -1) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    RingSegment *seg = (RingSegment*) mmap(NULL, sizeof(RingSegment),
+                                           PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    ring_init(&seg->to_client);
+    ring_init(&seg->to_server);
+    seg->attached = 0;
+    seg->magic = RING_MAGIC;
+    return seg;
+}
+
+RingSegment* ring_segment_attach(const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(RingSegment)) {
+        close(fd);
+        return NULL;
+    }
+
+    RingSegment *seg = (RingSegment*) mmap(NULL, sizeof(RingSegment),
+                                           PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) return NULL;
+
+    if (seg->magic != RING_MAGIC) {
+        munmap(seg, sizeof(RingSegment));
+        return NULL;
+    }
+    seg->attached = 1;
+    return seg;
+}
+
+void ring_segment_unmap(RingSegment *seg) {
+    if (seg) munmap(seg, sizeof(RingSegment));
+}
+
+ssize_t ring_write(SpscRing *r, const void *buf, size_t len) {
+    const char *src = (const char*)buf;
+    size_t done = 0;
+
+    while (done < len) {
+        if (atomic_load(&r->closed)) return -1;
+
+        uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+        uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        uint32_t space = RING_CAPACITY - (head - tail);
+
+        if (space == 0) {
+            // Announce, re-check, then sleep until the consumer moves tail
+            atomic_store(&r->writer_waiting, 1);
+            if (atomic_load(&r->tail) == tail && !atomic_load(&r->closed)) {
+                ring_futex_wait(&r->tail, tail, -1);
+            }
+            atomic_store(&r->writer_waiting, 0);
+            continue;
+        }
+
+        size_t n = len - done;
+        if (n > space) n = space;
+
+        uint32_t off = head & (RING_CAPACITY - 1);
+        size_t first = RING_CAPACITY - off;
+        if (first > n) first = n;
+        memcpy(r->data + off, src + done, first);
+        memcpy(r->data, src + done + first, n - first);
+
+        atomic_store(&r->head, head + (uint32_t)n);
+        if (atomic_load(&r->reader_waiting)) ring_futex_wake(&r->head);
+        done += n;
+    }
+    return (ssize_t)len;
+}
+
+ssize_t ring_read(SpscRing *r, void *buf, size_t len) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t avail = head - tail;
+
+    if (avail == 0) {
+        if (atomic_load(&r->closed)) return 0;
+        errno = EAGAIN;
+        return -1;
+    }
+
+    size_t n = avail;
+    if (n > len) n = len;
+
+    uint32_t off = tail & (RING_CAPACITY - 1);
+    size_t first = RING_CAPACITY - off;
+    if (first > n) first = n;
+    memcpy(buf, r->data + off, first);
+    memcpy((char*)buf + first, r->data, n - first);
+
+    atomic_store(&r->tail, tail + (uint32_t)n);
+    if (atomic_load(&r->writer_waiting)) ring_futex_wake(&r->tail);
+    return (ssize_t)n;
+}
+
+int ring_wait(SpscRing *r, int timeout_ms) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (atomic_load(&r->head) != tail || atomic_load(&r->closed)) return 1;
+
+    atomic_store(&r->reader_waiting, 1);
+    long rc = 0;
+    if (atomic_load(&r->head) == tail && !atomic_load(&r->closed)) {
+        rc = ring_futex_wait(&r->head, tail, timeout_ms);
+    }
+    atomic_store(&r->reader_waiting, 0);
+
+    if (atomic_load(&r->head) != tail || atomic_load(&r->closed)) return 1;
+    if (rc == -1 && errno == ETIMEDOUT) return 0;
+    if (rc == -1 && errno == EINTR) return -1;
+    return (timeout_ms < 0) ? 1 : 0;
+}
+
+void ring_close(SpscRing *r) {
+    atomic_store(&r->closed, 1);
+    ring_futex_wake(&r->head);
+    ring_futex_wake(&r->tail);
+}
+
+unsigned long ring_syscalls(void) {
+    return futex_calls;
+}
@@ -0,0 +1,65 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Lock-free single-producer/single-consumer byte rings in a shared-memory
+// segment, one per direction between a client and its server session.
+// Data is copied straight into the peer's mapping; a futex wakeup is only
+// issued when the other side is actually parked waiting for it.
+
+#define RING_CAPACITY (64 * 1024)          // power of two, same as a pipe
+#define RING_MAGIC    0x59525447u          // "YRTG"
+#define RING_NAME_SIZE 64
+
+typedef struct {
+    _Atomic uint32_t head;                 // bytes produced (producer-owned)
+    char pad0[60];
+    _Atomic uint32_t tail;                 // bytes consumed (consumer-owned)
+    char pad1[60];
+    _Atomic uint32_t reader_waiting;
+    _Atomic uint32_t writer_waiting;
+    _Atomic uint32_t closed;               // either side hung up
+    char pad2[52];
+    char data[RING_CAPACITY];
+} SpscRing;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t attached;                     // set by the server once mapped
+    SpscRing to_client;                    // server -> client
+    SpscRing to_server;                    // client -> server
+} RingSegment;
+
+// Client side: create and map a fresh segment under `name` ("/yahtzee_ring_<pid>").
+RingSegment* ring_segment_create(const char *name);
+
+// Server side: map an existing segment. Returns NULL if it is missing or invalid.
+RingSegment* ring_segment_attach(const char *name);
+
+void ring_segment_unmap(RingSegment *seg);
+
+// Copy `len` bytes into the ring, waiting for space if it is full.
+// Returns len, or -1 if the consumer side is gone.
+ssize_t ring_write(SpscRing *r, const void *buf, size_t len);
+
+// Copy up to `len` available bytes out of the ring without waiting.
+// Returns bytes read, 0 if the producer closed and the ring is empty,
+// -1 (errno = EAGAIN) if nothing is available yet.
+ssize_t ring_read(SpscRing *r, void *buf, size_t len);
+
+// Wait until data is available or the ring is closed.
+// timeout_ms < 0 waits forever. Returns 1 ready, 0 timeout, -1 interrupted.
+int ring_wait(SpscRing *r, int timeout_ms);
+
+// Either side hangs up. A consumer drains what is left and then sees EOF;
+// a producer gets -1 from further writes.
+void ring_close(SpscRing *r);
+
+// Futex syscalls issued so far by the calling thread (for I/O accounting).
+unsigned long ring_syscalls(void);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Dice generator: xoshiro256** with one stream per player per match.
+//
+// A match has a 64-bit seed. Player 0's stream is seeded from it through
+// splitmix64, and each following player's stream starts 2^128 draws
+// further on (the xoshiro jump), so the seats' streams never overlap. A
+// player's dice depend only on the match seed, the seat and how many dice
+// that player has rolled before, not on how the sessions interleave, so a
+// recorded seed replays a match bit for bit. The state is plain data that
+// lives in shared memory with the rest of the match.
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static inline uint64_t rng_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t out = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return out;
+}
+
+// 1..6 from the top 32 bits by multiply-shift: no division, and a bias of
+// at most 6 / 2^32 (rand() % 6 had more)
+static inline int rng_die(Rng *r) {
+    return (int)(((rng_next(r) >> 32) * 6) >> 32) + 1;
+}
+
+// Advance 2^128 draws
+static inline void rng_jump(Rng *r) {
+    static const uint64_t jump[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    uint64_t t[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                for (int k = 0; k < 4; k++) t[k] ^= r->s[k];
+            }
+            rng_next(r);
+        }
+    }
+    for (int k = 0; k < 4; k++) r->s[k] = t[k];
+}
+
+// Seed of match number `n` under a run seed (--seed): the n-th splitmix64
+// output, so any one match can be derived without the ones before it
+static inline uint64_t rng_match_seed(uint64_t run_seed, uint64_t n) {
+    uint64_t x = run_seed + n * 0x9E3779B97F4A7C15ULL;
+    return rng_splitmix64(&x);
+}
+
+// Streams for players 0..n-1 of the match with this seed
+static inline void rng_seed_match(Rng *streams, int n, uint64_t match_seed) {
+    uint64_t x = match_seed;
+    for (int k = 0; k < 4; k++) streams[0].s[k] = rng_splitmix64(&x);
+    for (int p = 1; p < n; p++) {
+        streams[p] = streams[p - 1];
+        rng_jump(&streams[p]);
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "scorefile.h"
+
+// One record without its '\n'. Returns 1 if it was valid.
+static int parse_line(const char *line, size_t len, scorefile_cb cb, void *ctx) {
+    if (len > 0 && line[len - 1] == '\r') len--;
+
+    size_t colon = len;
+    while (colon > 0 && line[colon - 1] != ':') colon--;
+    if (colon <= 1) return 0;              // no ':' or empty name
+    colon--;
+
+    size_t digits = len - colon - 1;
+    if (digits == 0 || digits > 9) return 0;
+    int wins = 0;
+    for (size_t i = colon + 1; i < len; i++) {
+        if (line[i] < '0' || line[i] > '9') return 0;
+        wins = wins * 10 + (line[i] - '0');
+    }
+
+    char name[SCOREFILE_NAME_SIZE];
+    size_t n = colon < sizeof(name) - 1 ? colon : sizeof(name) - 1;
+    memcpy(name, line, n);
+    name[n] = '\0';
+
+    cb(name, wins, ctx);
+    return 1;
+}
+
+long scorefile_parse(int fd, scorefile_cb cb, void *ctx) {
+    char *buf = (char*)malloc(SCOREFILE_CHUNK);
+    if (!buf) return -1;
+
+    size_t have = 0;                       // bytes of an unfinished line at buf[0]
+    int skipping = 0;                      // inside a line longer than the buffer
+    long records = 0;
+
+    while (1) {
+        ssize_t r = read(fd, buf + have, SCOREFILE_CHUNK - have);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            free(buf);
+            return -1;
+        }
+        if (r == 0) break;
+        have += (size_t)r;
+
+        char *start = buf;
+        char *end = buf + have;
+        char *nl;
+        while ((nl = (char*)memchr(start, '\n', (size_t)(end - start))) != NULL) {
+            if (!skipping) records += parse_line(start, (size_t)(nl - start), cb, ctx);
+            skipping = 0;
+            start = nl + 1;
+        }
+
+        // Carry the partial record over to the next read
+        have = (size_t)(end - start);
+        if (have == SCOREFILE_CHUNK) {
+            skipping = 1;
+            have = 0;
+        } else if (have > 0 && start != buf) {
+            memmove(buf, start, have);
+        }
+    }
+
+    // Last record without a trailing newline
+    if (have > 0 && !skipping) records += parse_line(buf, have, cb, ctx);
+
+    free(buf);
+    return records;
+}
@@ -0,0 +1,22 @@
+#ifndef SCOREFILE_H
+#define SCOREFILE_H
+
+#include <stddef.h>
+
+// Streaming reader for the legacy scores.txt format: one "name:wins" record
+// per line. The file is read in fixed chunks and a record cut by a chunk
+// boundary is carried over to the next read, so files of any size are
+// parsed in a single pass with constant memory. The last ':' on a line
+// separates the name from the count, so names may contain ':'. Malformed
+// lines and lines longer than a whole chunk are skipped.
+
+#define SCOREFILE_CHUNK     65536
+#define SCOREFILE_NAME_SIZE 50             // longer names are truncated
+
+typedef void (*scorefile_cb)(const char *name, int wins, void *ctx);
+
+// Calls `cb` once per valid record read from `fd` until EOF.
+// Returns the number of records, or -1 on a read error.
+long scorefile_parse(int fd, scorefile_cb cb, void *ctx);
+
+#endif
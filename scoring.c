@@ -0,0 +1,163 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "scoring.h"
+
+#define ORDERED_KEYS 7776   // 6^5 ordered rolls
+
+static unsigned char roll_dice_tab[SCORING_NUM_ROLLS][5];
+static unsigned char roll_counts_tab[SCORING_NUM_ROLLS][7];
+static short         roll_scores_tab[SCORING_NUM_ROLLS][SCORING_NUM_CATEGORIES];
+static unsigned char key_to_index[ORDERED_KEYS];
+
+static pthread_once_t scoring_once = PTHREAD_ONCE_INIT;
+
+static const char *category_names[SCORING_NUM_CATEGORIES] = {
+    "Aces", "Twos", "Threes", "Fours", "Fives", "Sixes",
+    "Three of a Kind", "Four of a Kind", "Full House",
+    "Small Straight", "Large Straight", "Yahtzee", "Chance"
+};
+
+
+// Rule predicates (only used while building the tables)
+
+static int has_n_of_a_kind(const int dice[], int n) {
+    for (int num = 1; num <= 6; num++) {
+        int count = 0;
+        for (int i = 0; i < 5; i++) {
+            if (dice[i] == num) count++;
+        }
+        if (count >= n) return 1;
+    }
+    return 0;
+}
+
+static int is_full_house(const int dice[]) {
+    int counts[7] = {0};
+    for (int i = 0; i < 5; i++) counts[dice[i]]++;
+    int has_three = 0, has_two = 0;
+    for (int i = 1; i <= 6; i++) {
+        if (counts[i] == 3) has_three = 1;
+        if (counts[i] == 2) has_two = 1;
+    }
+    return has_three && has_two;
+}
+
+static int has_small_straight(const int dice[]) {
+    int present[7] = {0};
+    for (int i = 0; i < 5; i++) present[dice[i]] = 1;
+    return (present[1] && present[2] && present[3] && present[4]) ||
+           (present[2] && present[3] && present[4] && present[5]) ||
+           (present[3] && present[4] && present[5] && present[6]);
+}
+
+static int has_large_straight(const int dice[]) {
+    int present[7] = {0};
+    for (int i = 0; i < 5; i++) present[dice[i]] = 1;
+    return (present[1] && present[2] && present[3] && present[4] && present[5]) ||
+           (present[2] && present[3] && present[4] && present[5] && present[6]);
+}
+
+static int ordered_key(const int dice[5]) {
+    int key = 0;
+    for (int i = 0; i < 5; i++) key = key * 6 + (dice[i] - 1);
+    return key;
+}
+
+static void score_sorted_roll(const int dice[5], short out[SCORING_NUM_CATEGORIES]) {
+    int sum = 0;
+    for (int i = 0; i < SCORING_NUM_CATEGORIES; i++) out[i] = 0;
+    for (int i = 0; i < 5; i++) {
+        out[dice[i] - 1] += dice[i];
+        sum += dice[i];
+    }
+
+    if (has_n_of_a_kind(dice, 3)) out[CAT_THREE_KIND] = sum;
+    if (has_n_of_a_kind(dice, 4)) out[CAT_FOUR_KIND]  = sum;
+    if (is_full_house(dice))      out[CAT_FULL_HOUSE] = 25;
+    if (has_small_straight(dice)) out[CAT_SMALL_STRAIGHT] = 30;
+    if (has_large_straight(dice)) out[CAT_LARGE_STRAIGHT] = 40;
+    if (has_n_of_a_kind(dice, 5)) out[CAT_YAHTZEE] = 50;
+    out[CAT_CHANCE] = sum;
+}
+
+static void build_tables(void) {
+    static short sorted_key_index[ORDERED_KEYS];
+    int idx = 0;
+
+    for (int i = 0; i < ORDERED_KEYS; i++) sorted_key_index[i] = -1;
+
+    // Enumerate sorted rolls in lexicographic order
+    for (int a = 1; a <= 6; a++)
+    for (int b = a; b <= 6; b++)
+    for (int c = b; c <= 6; c++)
+    for (int d = c; d <= 6; d++)
+    for (int e = d; e <= 6; e++) {
+        int dice[5] = {a, b, c, d, e};
+        memset(roll_counts_tab[idx], 0, sizeof(roll_counts_tab[idx]));
+        for (int i = 0; i < 5; i++) {
+            roll_dice_tab[idx][i] = (unsigned char)dice[i];
+            roll_counts_tab[idx][dice[i]]++;
+        }
+        score_sorted_roll(dice, roll_scores_tab[idx]);
+        sorted_key_index[ordered_key(dice)] = (short)idx;
+        idx++;
+    }
+
+    // Every ordered roll maps to the index of its sorted form
+    for (int key = 0; key < ORDERED_KEYS; key++) {
+        int counts[7] = {0};
+        int k = key;
+        for (int i = 0; i < 5; i++) { counts[k % 6 + 1]++; k /= 6; }
+
+        int sorted[5], n = 0;
+        for (int f = 1; f <= 6; f++)
+            for (int c = 0; c < counts[f]; c++) sorted[n++] = f;
+
+        key_to_index[key] = (unsigned char)sorted_key_index[ordered_key(sorted)];
+    }
+}
+
+const char *scoring_category_name(int cat) {
+    if (cat < 0 || cat >= SCORING_NUM_CATEGORIES) return "?";
+    return category_names[cat];
+}
+
+void scoring_init(void) {
+    pthread_once(&scoring_once, build_tables);
+}
+
+int scoring_roll_index(const int dice[5]) {
+    for (int i = 0; i < 5; i++) {
+        if (dice[i] < 1 || dice[i] > 6) return -1;
+    }
+    return key_to_index[ordered_key(dice)];
+}
+
+const unsigned char *scoring_roll_dice(int roll_index) {
+    return roll_dice_tab[roll_index];
+}
+
+const unsigned char *scoring_roll_counts(int roll_index) {
+    return roll_counts_tab[roll_index];
+}
+
+const short *scoring_roll_scores(int roll_index) {
+    return roll_scores_tab[roll_index];
+}
+
+void scoring_possible_scores(int roll_index, int yahtzee_joker, int out[SCORING_NUM_CATEGORIES]) {
+    if (roll_index < 0) {
+        for (int i = 0; i < SCORING_NUM_CATEGORIES; i++) out[i] = 0;
+        return;
+    }
+
+    const short *s = roll_scores_tab[roll_index];
+    for (int i = 0; i < SCORING_NUM_CATEGORIES; i++) out[i] = s[i];
+
+    if (yahtzee_joker && s[CAT_YAHTZEE] == 50) {
+        out[CAT_FULL_HOUSE]     = 25;
+        out[CAT_SMALL_STRAIGHT] = 30;
+        out[CAT_LARGE_STRAIGHT] = 40;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SCORING_H
+#define SCORING_H
+
+#include <stddef.h>
+
+// Table-driven scoring engine.
+// A roll of five dice is reduced to one of the 252 distinct sorted rolls
+// (multisets of five faces); every category score for every roll is
+// computed once by scoring_init() and then served by a single lookup.
+
+#define SCORING_NUM_ROLLS 252
+#define SCORING_NUM_CATEGORIES 13
+
+// Scorecard rows (same order as player_scores in the server)
+enum {
+    CAT_ACES = 0, CAT_TWOS, CAT_THREES, CAT_FOURS, CAT_FIVES, CAT_SIXES,
+    CAT_THREE_KIND, CAT_FOUR_KIND, CAT_FULL_HOUSE,
+    CAT_SMALL_STRAIGHT, CAT_LARGE_STRAIGHT, CAT_YAHTZEE, CAT_CHANCE
+};
+
+// Display name of a category ("Aces" .. "Chance").
+const char *scoring_category_name(int cat);
+
+// Build the lookup tables. Safe to call more than once / from any thread.
+void scoring_init(void);
+
+// Map five dice (1..6, any order) to their sorted-roll index 0..251.
+int scoring_roll_index(const int dice[5]);
+
+// Sorted faces of a roll index (ascending).
+const unsigned char *scoring_roll_dice(int roll_index);
+
+// Face counts of a roll index, counts[1..6] (counts[0] is unused).
+const unsigned char *scoring_roll_counts(int roll_index);
+
+// Raw category scores for a roll index (no Joker overrides).
+const short *scoring_roll_scores(int roll_index);
+
+// All 13 possible scores for a roll. When yahtzee_joker is set and the roll
+// is a Yahtzee, Full House / Small Straight / Large Straight score in full.
+void scoring_possible_scores(int roll_index, int yahtzee_joker, int out[SCORING_NUM_CATEGORIES]);
+
+// Batch scoring (scoring_batch.c), for simulation and solver workloads.
+// Structure of arrays for n hands:
+//   dice   5 rows of n faces: die i of hand h is dice[i * n + h]
+//   joker  n flags (Yahtzee already scored as 50), or NULL for none
+//   out    13 rows of n scores: category c of hand h is out[c * n + h]
+// Every hand gets exactly what scoring_possible_scores gives it, Joker
+// overrides and all-zero rows for dice outside 1..6 included.
+
+typedef enum {
+    SCORING_ISA_SCALAR = 0,                // per hand through the roll tables
+    SCORING_ISA_SSE2,                      // 16 hands per instruction
+    SCORING_ISA_AVX2                       // 32 hands per instruction
+} ScoringIsa;
+
+// Best kernel this CPU runs
+ScoringIsa scoring_batch_best_isa(void);
+const char *scoring_isa_name(ScoringIsa isa);
+
+void scoring_batch(const unsigned char *dice, const unsigned char *joker, size_t n, short *out);
+
+// The same with a chosen kernel (one the CPU lacks falls back to the best
+// it has), for benchmarks and cross-checks
+void scoring_batch_isa(ScoringIsa isa, const unsigned char *dice, const unsigned char *joker,
+                       size_t n, short *out);
+
+#endif
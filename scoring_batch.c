@@ -0,0 +1,210 @@
+#include <stddef.h>
+
+#include "scoring.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCORING_X86 1
+#include <immintrin.h>
+#endif
+
+// Batch scoring kernels.
+//
+// The vector kernels score from the dice directly instead of the roll
+// tables: every category value fits in a byte (at most 50), so one AVX2
+// instruction works on 32 hands and one SSE2 instruction on 16. Per hand:
+// face counts by compare-and-subtract, upper boxes as count * face by
+// additions, n-of-a-kind from the largest count, full house from "some
+// count is 3 and some count is 2", straights from the faces present, then
+// the Joker override and a mask that zeroes hands with a die outside 1..6
+// (scoring_possible_scores gives those all zeros too). Bytes are widened
+// to shorts only for the store. Hands left over after the last full
+// vector go through the scalar path.
+
+static const char *isa_names[] = {"scalar", "sse2", "avx2"};
+
+const char *scoring_isa_name(ScoringIsa isa) {
+    return (isa >= SCORING_ISA_SCALAR && isa <= SCORING_ISA_AVX2) ? isa_names[isa] : "?";
+}
+
+ScoringIsa scoring_batch_best_isa(void) {
+#ifdef SCORING_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SCORING_ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SCORING_ISA_SSE2;
+#endif
+    return SCORING_ISA_SCALAR;
+}
+
+// One hand at a time through the roll tables, as calculate_possible_scores does
+static void batch_scalar(const unsigned char *dice, const unsigned char *joker,
+                         size_t n, size_t from, short *out) {
+    for (size_t h = from; h < n; h++) {
+        int d[5], s[SCORING_NUM_CATEGORIES];
+        for (int i = 0; i < 5; i++) d[i] = dice[i * n + h];
+        scoring_possible_scores(scoring_roll_index(d), joker && joker[h], s);
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) out[c * n + h] = (short)s[c];
+    }
+}
+
+#ifdef SCORING_X86
+
+__attribute__((target("avx2")))
+static size_t batch_avx2(const unsigned char *dice, const unsigned char *joker, size_t n, short *out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t h = 0;
+
+    for (; h + 32 <= n; h += 32) {
+        __m256i d[5], c[7];
+        __m256i valid = _mm256_set1_epi8(-1), sum = zero;
+        for (int i = 0; i < 5; i++) {
+            d[i] = _mm256_loadu_si256((const __m256i*)(dice + i * n + h));
+            __m256i dm1 = _mm256_sub_epi8(d[i], one);            // 1..6 -> 0..5, else >= 6
+            valid = _mm256_and_si256(valid, _mm256_cmpeq_epi8(_mm256_min_epu8(dm1, _mm256_set1_epi8(5)), dm1));
+            sum = _mm256_add_epi8(sum, d[i]);
+        }
+
+        __m256i maxc = zero, has3 = zero, has2 = zero, present[7];
+        for (int f = 1; f <= 6; f++) {
+            __m256i face = _mm256_set1_epi8((char)f);
+            c[f] = zero;
+            for (int i = 0; i < 5; i++) c[f] = _mm256_sub_epi8(c[f], _mm256_cmpeq_epi8(d[i], face));
+            maxc = _mm256_max_epu8(maxc, c[f]);
+            has3 = _mm256_or_si256(has3, _mm256_cmpeq_epi8(c[f], _mm256_set1_epi8(3)));
+            has2 = _mm256_or_si256(has2, _mm256_cmpeq_epi8(c[f], _mm256_set1_epi8(2)));
+            present[f] = _mm256_andnot_si256(_mm256_cmpeq_epi8(c[f], zero), valid);
+        }
+
+        __m256i kind3 = _mm256_cmpeq_epi8(_mm256_max_epu8(maxc, _mm256_set1_epi8(3)), maxc);
+        __m256i kind4 = _mm256_cmpeq_epi8(_mm256_max_epu8(maxc, _mm256_set1_epi8(4)), maxc);
+        __m256i kind5 = _mm256_cmpeq_epi8(maxc, _mm256_set1_epi8(5));
+        __m256i full = _mm256_and_si256(has3, has2);
+        __m256i mid = _mm256_and_si256(_mm256_and_si256(present[3], present[4]), present[2]);
+        __m256i mid5 = _mm256_and_si256(mid, present[5]);
+        __m256i small = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(mid, present[1]), mid5),
+                                        _mm256_and_si256(_mm256_and_si256(present[3], present[4]),
+                                                         _mm256_and_si256(present[5], present[6])));
+        __m256i large = _mm256_or_si256(_mm256_and_si256(mid5, present[1]), _mm256_and_si256(mid5, present[6]));
+
+        if (joker) {
+            __m256i j = _mm256_loadu_si256((const __m256i*)(joker + h));
+            __m256i jy = _mm256_andnot_si256(_mm256_cmpeq_epi8(j, zero), kind5);
+            full = _mm256_or_si256(full, jy);
+            small = _mm256_or_si256(small, jy);
+            large = _mm256_or_si256(large, jy);
+        }
+
+        __m256i row[SCORING_NUM_CATEGORIES];
+        for (int f = 1; f <= 6; f++) {
+            __m256i c2 = _mm256_add_epi8(c[f], c[f]), c4 = _mm256_add_epi8(c2, c2);
+            __m256i v = (f == 1) ? c[f] : (f == 2) ? c2 : (f == 3) ? _mm256_add_epi8(c2, c[f])
+                      : (f == 4) ? c4 : (f == 5) ? _mm256_add_epi8(c4, c[f]) : _mm256_add_epi8(c4, c2);
+            row[f - 1] = v;
+        }
+        row[CAT_THREE_KIND]     = _mm256_and_si256(kind3, sum);
+        row[CAT_FOUR_KIND]      = _mm256_and_si256(kind4, sum);
+        row[CAT_FULL_HOUSE]     = _mm256_and_si256(full, _mm256_set1_epi8(25));
+        row[CAT_SMALL_STRAIGHT] = _mm256_and_si256(small, _mm256_set1_epi8(30));
+        row[CAT_LARGE_STRAIGHT] = _mm256_and_si256(large, _mm256_set1_epi8(40));
+        row[CAT_YAHTZEE]        = _mm256_and_si256(kind5, _mm256_set1_epi8(50));
+        row[CAT_CHANCE]         = sum;
+
+        for (int k = 0; k < SCORING_NUM_CATEGORIES; k++) {
+            __m256i v = _mm256_and_si256(row[k], valid);
+            short *dst = out + k * n + h;
+            _mm256_storeu_si256((__m256i*)dst, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+            _mm256_storeu_si256((__m256i*)(dst + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+        }
+    }
+    return h;
+}
+
+__attribute__((target("sse2")))
+static size_t batch_sse2(const unsigned char *dice, const unsigned char *joker, size_t n, short *out) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    size_t h = 0;
+
+    for (; h + 16 <= n; h += 16) {
+        __m128i d[5], c[7];
+        __m128i valid = _mm_set1_epi8(-1), sum = zero;
+        for (int i = 0; i < 5; i++) {
+            d[i] = _mm_loadu_si128((const __m128i*)(dice + i * n + h));
+            __m128i dm1 = _mm_sub_epi8(d[i], one);
+            valid = _mm_and_si128(valid, _mm_cmpeq_epi8(_mm_min_epu8(dm1, _mm_set1_epi8(5)), dm1));
+            sum = _mm_add_epi8(sum, d[i]);
+        }
+
+        __m128i maxc = zero, has3 = zero, has2 = zero, present[7];
+        for (int f = 1; f <= 6; f++) {
+            __m128i face = _mm_set1_epi8((char)f);
+            c[f] = zero;
+            for (int i = 0; i < 5; i++) c[f] = _mm_sub_epi8(c[f], _mm_cmpeq_epi8(d[i], face));
+            maxc = _mm_max_epu8(maxc, c[f]);
+            has3 = _mm_or_si128(has3, _mm_cmpeq_epi8(c[f], _mm_set1_epi8(3)));
+            has2 = _mm_or_si128(has2, _mm_cmpeq_epi8(c[f], _mm_set1_epi8(2)));
+            present[f] = _mm_andnot_si128(_mm_cmpeq_epi8(c[f], zero), valid);
+        }
+
+        __m128i kind3 = _mm_cmpeq_epi8(_mm_max_epu8(maxc, _mm_set1_epi8(3)), maxc);
+        __m128i kind4 = _mm_cmpeq_epi8(_mm_max_epu8(maxc, _mm_set1_epi8(4)), maxc);
+        __m128i kind5 = _mm_cmpeq_epi8(maxc, _mm_set1_epi8(5));
+        __m128i full = _mm_and_si128(has3, has2);
+        __m128i mid = _mm_and_si128(_mm_and_si128(present[3], present[4]), present[2]);
+        __m128i mid5 = _mm_and_si128(mid, present[5]);
+        __m128i small = _mm_or_si128(_mm_or_si128(_mm_and_si128(mid, present[1]), mid5),
+                                     _mm_and_si128(_mm_and_si128(present[3], present[4]),
+                                                   _mm_and_si128(present[5], present[6])));
+        __m128i large = _mm_or_si128(_mm_and_si128(mid5, present[1]), _mm_and_si128(mid5, present[6]));
+
+        if (joker) {
+            __m128i j = _mm_loadu_si128((const __m128i*)(joker + h));
+            __m128i jy = _mm_andnot_si128(_mm_cmpeq_epi8(j, zero), kind5);
+            full = _mm_or_si128(full, jy);
+            small = _mm_or_si128(small, jy);
+            large = _mm_or_si128(large, jy);
+        }
+
+        __m128i row[SCORING_NUM_CATEGORIES];
+        for (int f = 1; f <= 6; f++) {
+            __m128i c2 = _mm_add_epi8(c[f], c[f]), c4 = _mm_add_epi8(c2, c2);
+            __m128i v = (f == 1) ? c[f] : (f == 2) ? c2 : (f == 3) ? _mm_add_epi8(c2, c[f])
+                      : (f == 4) ? c4 : (f == 5) ? _mm_add_epi8(c4, c[f]) : _mm_add_epi8(c4, c2);
+            row[f - 1] = v;
+        }
+        row[CAT_THREE_KIND]     = _mm_and_si128(kind3, sum);
+        row[CAT_FOUR_KIND]      = _mm_and_si128(kind4, sum);
+        row[CAT_FULL_HOUSE]     = _mm_and_si128(full, _mm_set1_epi8(25));
+        row[CAT_SMALL_STRAIGHT] = _mm_and_si128(small, _mm_set1_epi8(30));
+        row[CAT_LARGE_STRAIGHT] = _mm_and_si128(large, _mm_set1_epi8(40));
+        row[CAT_YAHTZEE]        = _mm_and_si128(kind5, _mm_set1_epi8(50));
+        row[CAT_CHANCE]         = sum;
+
+        for (int k = 0; k < SCORING_NUM_CATEGORIES; k++) {
+            __m128i v = _mm_and_si128(row[k], valid);
+            short *dst = out + k * n + h;
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi8(v, zero));
+        }
+    }
+    return h;
+}
+
+#endif
+
+void scoring_batch_isa(ScoringIsa isa, const unsigned char *dice, const unsigned char *joker,
+                       size_t n, short *out) {
+    scoring_init();
+    if (isa > scoring_batch_best_isa()) isa = scoring_batch_best_isa();
+
+    size_t done = 0;
+#ifdef SCORING_X86
+    if (isa == SCORING_ISA_AVX2) done = batch_avx2(dice, joker, n, out);
+    else if (isa == SCORING_ISA_SSE2) done = batch_sse2(dice, joker, n, out);
+#endif
+    batch_scalar(dice, joker, n, done, out);
+}
+
+void scoring_batch(const unsigned char *dice, const unsigned char *joker, size_t n, short *out) {
+    scoring_batch_isa(scoring_batch_best_isa(), dice, joker, n, out);
+}
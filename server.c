@@ -1,8 +1,11 @@
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE             // MAP_ANONYMOUS
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -15,10 +18,32 @@
 #include <fcntl.h>
 #include <time.h>
 #include <poll.h>
+#include <stdint.h>
+#include <math.h>
 #include <sys/file.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <sys/signalfd.h>
+
+#include "bot.h"
+#include "ckpt.h"
+#include "futex.h"
+#include "hint.h"
+#include "journal.h"
+#include "mpsc.h"
+#include "protocol.h"
+#include "ring.h"
+#include "rng.h"
+#include "scorefile.h"
+#include "scoring.h"
+#include "snapshot.h"
+#include "solver.h"
+#include "store.h"
 
 // Configuration
 #define MAX_PLAYERS 5
+#define DEFAULT_LOBBIES 4
 #define MAX_ROUNDS 13
 #define NAME_SIZE 50
 #define BUFFER_SIZE 2048
@@ -26,15 +51,33 @@
 #define SERVER_FIFO "/tmp/yahtzee/server_fifo"
 
 #define QUANTUM_SECONDS 60
+#define RESUME_GRACE_SECONDS 120    // a restored seat waits this long for its player
+#define RECONNECT_GRACE_SECONDS 60  // likewise the seat of a player who lost the connection
 
-#define LOG_QUEUE_SIZE 50
+#define LOG_RING_SLOTS 1024
 #define LOG_MSG_LEN 256
-
-// Shared Memory Structure
+#define LOG_BATCH_MAX 64            // records gathered into one write()
+
+#define SCORES_DB "scores.db"
+#define JOURNAL_FILE "matches.jnl"   // binary match journal (journal.h)
+#define CHECKPOINT_FILE "matches.ckpt"  // running matches, one slot per lobby (ckpt.h)
+#define LEGACY_SCORES "scores.txt"   // imported once into a fresh scores.db
+
+// Where a player's turn stands, so a player who reconnects mid-turn picks
+// it up with the same dice instead of rolling again
+typedef enum {
+    TURN_IDLE,          // no turn in progress
+    TURN_ROLLED,        // dice rolled, rerolls may be left
+    TURN_SCORING        // Yahtzee rules applied, choosing a category
+} TurnPhase;
+
+// Shared Memory Structure (one block per lobby)
 typedef struct {
+    int lobby_id;
     int current_turn;
     int active_players;
     int target_players;
+    int bot_fill;                       // BotLevel the host wants empty seats filled with
     int host_player_id;
     int game_started;
     int game_round;
@@ -49,12 +92,23 @@ typedef struct {
 
     char player_names[MAX_PLAYERS][NAME_SIZE];
     int  player_connected[MAX_PLAYERS];
+    int  player_bot[MAX_PLAYERS];       // BotLevel of a server-run seat, 0 = human
 
     pid_t child_pid[MAX_PLAYERS];
     volatile sig_atomic_t force_end_turn[MAX_PLAYERS];
 
     int  player_dice[MAX_PLAYERS][5];
     int  player_rerolls_left[MAX_PLAYERS];
+    char turn_phase[MAX_PLAYERS];       // TurnPhase: how far the player's turn got
+    uint32_t match_no;                  // number of this match in the run (journal id)
+    uint64_t match_seed;                // logged at game start; replays every roll
+    Rng  player_rng[MAX_PLAYERS];       // player p's dice stream (rng.h)
+    uint32_t player_draws[MAX_PLAYERS]; // dice drawn from player_rng so far
+
+    // A human participant's claim on their seat: the client presents the
+    // token to take the seat back while it is held (reserve_until)
+    uint64_t seat_token[MAX_PLAYERS];
+    struct timespec reserve_until[MAX_PLAYERS];   // tv_sec 0 = not held
 
     int  player_scores[MAX_PLAYERS][15][3];
 
@@ -69,93 +123,158 @@ typedef struct {
 
     struct timespec turn_deadline[MAX_PLAYERS];
 
-    pthread_mutex_t game_mutex;
-    pthread_mutex_t log_mutex;
+    // Locking (all process-shared):
+    //   match_mutex       turn/lobby/end-game state: participants, connections,
+    //                     names, player_done, final scores, deadlines, lobby_cond
+    //   player_mutex[p]   player p's dice, dice stream, rerolls, scorecard and
+    //                     Yahtzee/bonus flags
+    // Lock order: match_mutex before any player_mutex, and player mutexes in
+    // ascending player order. Never take match_mutex while holding a player lock.
+    // A player's own session may read its dice/scorecard unlocked; only that
+    // session and the scheduler's disconnect forfeit write them.
+    pthread_mutex_t match_mutex;
+    pthread_mutex_t player_mutex[MAX_PLAYERS];
+    pthread_cond_t  lobby_cond;         // broadcast on target/start/connection changes
+    unsigned lobby_gen;                 // bumped with every lobby_cond broadcast
     sem_t turn_sem[MAX_PLAYERS];
     sem_t turn_done_sem[MAX_PLAYERS];
     int  turn_active[MAX_PLAYERS];
 
-    int total_wins[MAX_PLAYERS];
+    // I/O syscalls spent by each player's session on its last turn,
+    // plus running totals for the per-match average
+    int  turn_syscalls[MAX_PLAYERS];
+    unsigned long io_syscalls_total;
+    int  io_turns;
+
+    // Turn evaluations for the hint command, filled by the hint worker
+    HintSlot hints[MAX_PLAYERS];
 } GameState;
 
-GameState *game_state;
+// Shared memory arena: every lobby runs an independent match
+typedef struct {
+    int num_lobbies;
+    pthread_mutex_t leaders_mutex;      // serializes leaderboard snapshot writers
+    _Atomic uint32_t hint_signal;       // bumped by sessions posting a hint state
+    GameState lobbies[];
+} ServerArena;
+
+static ServerArena *arena;
+static size_t arena_size;
+
+// Lock-free read-only mirror of every lobby for spectators (snapshot.h)
+static SnapshotArena *snap_arena;
+
+// Opened once in the server; fork-mode children inherit the mapping
+static Store *score_store;
+
+// Optimal-play value table (solver.h), mapped read-only if strategy.bin exists
+static StrategyTable strategy;
 
-static pid_t server_pid;
+// CPU time each bot decision may take (bot.h)
+static long bot_budget_ns = BOT_DEFAULT_BUDGET_US * 1000L;
+
+_Static_assert(SNAP_MAX_PLAYERS == MAX_PLAYERS && SNAP_NAME_SIZE == NAME_SIZE,
+               "snapshot layout must match GameState");
+
+// Lobby the calling thread is working on (scheduler threads, client children)
+static __thread GameState *game_state;
+
+static int pool_mode = 0;
+static int notify_fd = -1;              // eventfd shared with every child
 static int g_child_player_id = -1;
+static GameState *g_child_state;
 
 static void sigusr1_handler(int sig) {
     (void)sig;
-    if (game_state && g_child_player_id >= 0 && g_child_player_id < MAX_PLAYERS) {
-        game_state->force_end_turn[g_child_player_id] = 1;
+    if (g_child_state && g_child_player_id >= 0 && g_child_player_id < MAX_PLAYERS) {
+        g_child_state->force_end_turn[g_child_player_id] = 1;
     }
 }
 
-// Logging Structure
-typedef struct {
-    char message[LOG_MSG_LEN];
-} LogEntry;
-
-LogEntry log_queue[LOG_QUEUE_SIZE];
-int log_head = 0;
-int log_tail = 0;
-
-pthread_mutex_t log_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
-sem_t log_items_sem;
-sem_t log_slots_sem;
-
-pthread_t logger_thread_id;
-
-static void update_section_flags_nolock(int player_id);
-static int  maybe_award_upper_bonus_nolock(int player_id);
-void* logger_thread_func(void* arg);
-void save_scores_to_file(void);
-void load_scores_from_file(void);
+// Wake the main loop: a lobby changed (target chosen, player left, game over)
+static void notify_server(void) {
+    if (notify_fd < 0) return;
+    uint64_t one = 1;
+    ssize_t r = write(notify_fd, &one, sizeof(one));
+    (void)r;
+}
 
-static void child_mark_disconnect_and_exit(int player_id, int write_fd, int read_fd);
+static void wake_sessions(void);
 
+// Snapshot publishing. Each writer already holds the lock that owns the
+// data, which is what serializes writers of the same seqlock section.
 
-// Helpers
+// Republish the match-level view (match_mutex held)
+static void publish_match_nolock(void) {
+    if (!snap_arena) return;
+    SnapMatch *m = &snap_arena->lobbies[game_state->lobby_id].match;
 
-int compare_int(const void *a, const void *b) {
-    return (*(int*)a - *(int*)b);
-}
+    int owner = -1;
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        if (game_state->turn_active[p]) owner = p;
+    }
 
-int has_n_of_a_kind(int dice[], int n) {
-    for (int num = 1; num <= 6; num++) {
-        int count = 0;
-        for (int i = 0; i < 5; i++) {
-            if (dice[i] == num) count++;
-        }
-        if (count >= n) return 1;
+    seqlock_write_begin(&m->seq);
+    m->game_started   = game_state->game_started;
+    m->game_finished  = game_state->game_finished;
+    m->target_players = game_state->target_players;
+    m->active_players = game_state->active_players;
+    m->turn_owner     = owner;
+    m->winner_id      = game_state->winner_id;
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        m->seats[p].connected   = game_state->player_connected[p];
+        m->seats[p].participant = game_state->participants[p];
+        m->seats[p].done        = game_state->player_done[p];
+        m->seats[p].final_score = game_state->final_scores[p];
+        memcpy(m->seats[p].name, game_state->player_names[p], NAME_SIZE);
     }
-    return 0;
+    seqlock_write_end(&m->seq);
 }
 
-int is_full_house(int dice[]) {
-    int counts[7] = {0};
-    for (int i = 0; i < 5; i++) counts[dice[i]]++;
-    int has_three = 0, has_two = 0;
-    for (int i = 1; i <= 6; i++) {
-        if (counts[i] == 3) has_three = 1;
-        if (counts[i] == 2) has_two = 1;
+// Republish one player's dice and scorecard (player lock held)
+static void publish_player_plocked(int player_id) {
+    if (!snap_arena) return;
+    SnapPlayer *sp = &snap_arena->lobbies[game_state->lobby_id].players[player_id];
+
+    seqlock_write_begin(&sp->seq);
+    int total = 0;
+    for (int i = 0; i < 5; i++) sp->dice[i] = game_state->player_dice[player_id][i];
+    sp->rerolls_left = game_state->player_rerolls_left[player_id];
+    for (int i = 0; i < 15; i++) {
+        sp->score[i]  = game_state->player_scores[player_id][i][0];
+        sp->scored[i] = (unsigned char)game_state->player_scores[player_id][i][1];
+        total += sp->score[i];
     }
-    return has_three && has_two;
+    sp->total = total;
+    seqlock_write_end(&sp->seq);
 }
 
-int has_small_straight(int dice[]) {
-    int present[7] = {0};
-    for (int i = 0; i < 5; i++) present[dice[i]] = 1;
-    return (present[1] && present[2] && present[3] && present[4]) ||
-           (present[2] && present[3] && present[4] && present[5]) ||
-           (present[3] && present[4] && present[5] && present[6]);
+// Lobby state changed: wake everything waiting on it (match_mutex held)
+static void lobby_changed_nolock(void) {
+    publish_match_nolock();
+    game_state->lobby_gen++;
+    pthread_cond_broadcast(&game_state->lobby_cond);
+    notify_server();
+    wake_sessions();
 }
 
-int has_large_straight(int dice[]) {
-    int present[7] = {0};
-    for (int i = 0; i < 5; i++) present[dice[i]] = 1;
-    return (present[1] && present[2] && present[3] && present[4] && present[5]) ||
-           (present[2] && present[3] && present[4] && present[5] && present[6]);
-}
+// Logging: every process (server, fork-mode children, pool workers) pushes
+// into one lock-free MPSC ring in a shared anonymous mapping created before
+// the first fork; the logger thread in the server drains it.
+static MpscRing *log_ring;
+
+pthread_t logger_thread_id;
+
+static void update_section_flags_plocked(int player_id);
+static int  maybe_award_upper_bonus_plocked(int player_id);
+void* logger_thread_func(void* arg);
+static void record_results_nolock(void);
+static void import_legacy_scores(void);
+
+static void child_mark_disconnect_and_exit(int player_id, int write_fd, int read_fd);
+
+
+// Helpers
 
 static int timespec_cmp(const struct timespec *a, const struct timespec *b) {
     if (a->tv_sec != b->tv_sec) return (a->tv_sec > b->tv_sec) ? 1 : -1;
@@ -179,65 +298,62 @@ static int ms_until_deadline(const struct timespec *deadline) {
     return (int)ms;
 }
 
-static int timed_read_line(int fd, char *buf, size_t sz, const struct timespec *deadline) {
-    int timeout_ms = ms_until_deadline(deadline);
-    if (timeout_ms <= 0) return -2;
-
-    // If scheduler forced this turn to end, treat as timeout
-    if (game_state && g_child_player_id >= 0 &&
-        g_child_player_id < MAX_PLAYERS &&
-        game_state->force_end_turn[g_child_player_id]) {
-        return -2;
-    }
-
-
-    struct pollfd pfd;
-    pfd.fd = fd;
-    pfd.events = POLLIN;
+// Never blocks: when the ring is full the message is dropped and counted
+void log_message(const char* msg) {
+    if (!log_ring) return;
+    mpsc_ring_push(log_ring, msg, strlen(msg));
+}
 
-    int pr = poll(&pfd, 1, timeout_ms);
-    if (pr == 0) return -2;
-    if (pr < 0) {
-        if (errno == EINTR) return -2; 
+static int init_log_ring(void) {
+    size_t size = mpsc_ring_size(LOG_RING_SLOTS, LOG_MSG_LEN);
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap log ring");
         return -1;
     }
-
-    int n = (int)read(fd, buf, sz - 1);
-    if (n > 0) buf[n] = '\0';
-    return n;
-}
-
-
-void log_message(const char* msg) {
-    if (getpid() != server_pid) return;
-    sem_wait(&log_slots_sem);
-    pthread_mutex_lock(&log_queue_mutex);
-    strncpy(log_queue[log_head].message, msg, LOG_MSG_LEN - 1);
-    log_queue[log_head].message[LOG_MSG_LEN - 1] = '\0';
-    log_head = (log_head + 1) % LOG_QUEUE_SIZE;
-    pthread_mutex_unlock(&log_queue_mutex);
-    sem_post(&log_items_sem);
+    log_ring = (MpscRing*)mem;
+    mpsc_ring_init(log_ring, LOG_RING_SLOTS, LOG_MSG_LEN);
+    return 0;
 }
 
 void* logger_thread_func(void* arg) {
     (void)arg;
 
-    FILE *fp = fopen("game.log", "a");
-    if (!fp) fp = stdout;
+    int fd = open("game.log", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) fd = STDOUT_FILENO;
 
-    while (1) {
-        sem_wait(&log_items_sem);
+    static char batch[LOG_BATCH_MAX * LOG_MSG_LEN + 256];
+    uint64_t reported_drops = 0, reported_abandoned = 0;
 
-        pthread_mutex_lock(&log_queue_mutex);
-        char msg[LOG_MSG_LEN];
-        strcpy(msg, log_queue[log_tail].message);
-        log_tail = (log_tail + 1) % LOG_QUEUE_SIZE;
-        pthread_mutex_unlock(&log_queue_mutex);
+    while (1) {
+        mpsc_ring_wait(log_ring, -1);
+
+        // Drain whatever has accumulated and write it in one go
+        size_t len = 0;
+        for (int i = 0; i < LOG_BATCH_MAX; i++) {
+            int n = mpsc_ring_pop(log_ring, batch + len, LOG_MSG_LEN);
+            if (n < 0) break;
+            len += (size_t)n;
+        }
 
-        sem_post(&log_slots_sem);
+        uint64_t drops = mpsc_ring_overflows(log_ring);
+        if (drops != reported_drops) {
+            len += (size_t)snprintf(batch + len, 128, "[LOG] %llu messages dropped (log ring full)\n",
+                                    (unsigned long long)(drops - reported_drops));
+            reported_drops = drops;
+        }
+        uint64_t abandoned = mpsc_ring_abandoned(log_ring);
+        if (abandoned != reported_abandoned) {
+            len += (size_t)snprintf(batch + len, 128, "[LOG] %llu messages lost (writer died mid-message)\n",
+                                    (unsigned long long)(abandoned - reported_abandoned));
+            reported_abandoned = abandoned;
+        }
 
-        fprintf(fp, "%s", msg);
-        fflush(fp);
+        if (len > 0) {
+            ssize_t r = write(fd, batch, len);
+            (void)r;
+        }
     }
     return NULL;
 }
@@ -245,6 +361,7 @@ void* logger_thread_func(void* arg) {
 
 // Detect client FIFO hangup even while the child is blocked
 typedef struct {
+    GameState *gs;
     int player_id;
     int read_fd;
     int write_fd;
@@ -252,14 +369,18 @@ typedef struct {
 
 static void* disconnect_watchdog(void* arg) {
     WatchArgs* wa = (WatchArgs*)arg;
+    game_state = wa->gs;
 
+    // No POLLIN: hangups are always reported, and pending input must not
+    // keep waking this thread while the session is not reading
     struct pollfd pfd;
     pfd.fd = wa->read_fd;
-    pfd.events = POLLIN | POLLHUP | POLLERR;
+    pfd.events = 0;
 
     while (1) {
-        int pr = poll(&pfd, 1, 200); 
+        int pr = poll(&pfd, 1, -1);
         if (pr > 0) {
+            if (pfd.revents & POLLNVAL) break;
             if (pfd.revents & (POLLHUP | POLLERR)) {
                 child_mark_disconnect_and_exit(wa->player_id, wa->write_fd, wa->read_fd);
             }
@@ -268,39 +389,160 @@ static void* disconnect_watchdog(void* arg) {
     return NULL;
 }
 
-// Wait for turn to complete but stop immediately if player disconnects or child dies
+// Wait for turn to complete but stop immediately if player disconnects or child dies.
+// Both of those post turn_done_sem, so a single wait up to the deadline covers them.
 static int wait_turn_done_or_disconnect(int pid, int quantum_sec) {
     struct timespec end;
     clock_gettime(CLOCK_REALTIME, &end);
     end.tv_sec += quantum_sec;
 
-    while (1) {
-        // If player disconnected, stop waiting immediately
-        if (!game_state->player_connected[pid]) return 1;
+    while (sem_timedwait(&game_state->turn_done_sem[pid], &end) == -1) {
+        if (errno == ETIMEDOUT) return game_state->player_connected[pid] ? -1 : 1;
+        if (errno != EINTR) break;
+    }
+    return game_state->player_connected[pid] ? 0 : 1;
+}
 
-        // If child process is gone, treat as disconnect
-        pid_t cpid = game_state->child_pid[pid];
-        if (cpid > 0 && kill(cpid, 0) == -1 && errno == ESRCH) return 1;
 
-        struct timespec now;
-        clock_gettime(CLOCK_REALTIME, &now);
-        if (timespec_cmp(&now, &end) >= 0) return -1; // timeout
+// Match seeding and journal
+
+// Run seed (--seed, else from the clock) and how many matches it has
+// seeded. Match seeds are derived in the parent, one per game start.
+static uint64_t run_seed;
+static _Atomic uint64_t matches_seeded;
+
+// Make the lobby's match number `n` of the run: its seed and every
+// seat's dice stream
+static void seed_match_nolock(uint64_t n) {
+    game_state->match_no = (uint32_t)n;
+    game_state->match_seed = rng_match_seed(run_seed, n);
+    rng_seed_match(game_state->player_rng, MAX_PLAYERS, game_state->match_seed);
+    memset(game_state->player_draws, 0, sizeof(game_state->player_draws));
+}
+
+// Journal record for this lobby's current match
+_Static_assert(JOURNAL_SEATS == MAX_PLAYERS, "journal END record holds every seat");
+
+static void journal_event(int type, int seat, const void *payload, size_t len) {
+    journal_push(type, game_state->lobby_id, game_state->match_no, seat, payload, len);
+}
+
+static void journal_score(int player_id, int category, int autofill, int points) {
+    unsigned char rec[4] = {(unsigned char)category, (unsigned char)autofill};
+    int16_t pts = (int16_t)points;
+    memcpy(rec + 2, &pts, 2);
+    journal_event(JNL_SCORE, player_id, rec, sizeof(rec));
+}
+
+static void journal_dice(unsigned char *out, int player_id) {
+    for (int i = 0; i < 5; i++) out[i] = (unsigned char)game_state->player_dice[player_id][i];
+}
+
+// The match's seed and who plays it, once the participants are fixed
+static void journal_match_start_nolock(void) {
+    unsigned char start[9];
+    memcpy(start, &game_state->match_seed, 8);
+    start[8] = 0;
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        if (game_state->participants[p]) start[8] |= (unsigned char)(1 << p);
+    }
+    journal_event(JNL_START, 0, start, sizeof(start));
+
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        if (!game_state->participants[p]) continue;
+        unsigned char join[1 + NAME_SIZE];
+        size_t n = strnlen(game_state->player_names[p], NAME_SIZE - 1);
+        join[0] = (unsigned char)game_state->player_bot[p];
+        memcpy(join + 1, game_state->player_names[p], n);
+        journal_event(JNL_JOIN, p, join, 1 + n);
+    }
+}
+
+
+// Match checkpoints (--resume)
+//
+// Each lobby's scheduler saves its match to CHECKPOINT_FILE between turns:
+// at the start, after every turn and (as "no match") at the end. That is
+// the only point where no session is half-way through a turn, so the
+// record needs no dice or reroll state and a restored match simply starts
+// the next turn. Writes are one pwrite of a couple of KB into the lobby's
+// double-buffered slot, done by the scheduler after the locks are dropped.
+
+#define CHECKPOINT_VERSION 1
+
+typedef struct {
+    uint32_t version;
+    int      active;                    // 0 = no match running in the lobby
+    uint32_t match_no;
+    uint64_t matches_seeded;            // the run's match counter when written
+    uint64_t match_seed;
+    int      next_turn;
+    int      participants[MAX_PLAYERS];
+    int      participants_count;
+    int      player_done[MAX_PLAYERS];
+    int      player_bot[MAX_PLAYERS];
+    char     player_names[MAX_PLAYERS][NAME_SIZE];
+    uint64_t seat_token[MAX_PLAYERS];
+    Rng      player_rng[MAX_PLAYERS];
+    uint32_t player_draws[MAX_PLAYERS];
+    int      player_scores[MAX_PLAYERS][15][3];
+    char     yahtzee_achieved[MAX_PLAYERS];
+    int      amount_yahtzee[MAX_PLAYERS];
+    int      required_upper_section[MAX_PLAYERS];
+    char     bonus_achieved[MAX_PLAYERS];
+    struct timespec turn_deadline[MAX_PLAYERS];
+} MatchCheckpoint;
+
+static Checkpoint *checkpoint;          // parent only; NULL = not checkpointing
+
+static void checkpoint_match(int next_turn) {
+    if (!checkpoint) return;
+
+    MatchCheckpoint m;
+    memset(&m, 0, sizeof(m));
+    m.version = CHECKPOINT_VERSION;
+
+    pthread_mutex_lock(&game_state->match_mutex);
+    m.active = game_state->game_started && !game_state->game_finished;
+    if (m.active) {
+        m.match_no = game_state->match_no;
+        m.matches_seeded = matches_seeded;
+        m.match_seed = game_state->match_seed;
+        m.next_turn = next_turn;
+        m.participants_count = game_state->participants_count;
+        memcpy(m.participants, game_state->participants, sizeof(m.participants));
+        memcpy(m.player_done, game_state->player_done, sizeof(m.player_done));
+        memcpy(m.player_bot, game_state->player_bot, sizeof(m.player_bot));
+        memcpy(m.player_names, game_state->player_names, sizeof(m.player_names));
+        memcpy(m.seat_token, game_state->seat_token, sizeof(m.seat_token));
+        memcpy(m.turn_deadline, game_state->turn_deadline, sizeof(m.turn_deadline));
 
-        // short slice wait for 200ms
-        struct timespec slice = now;
-        slice.tv_nsec += 200 * 1000 * 1000;
-        if (slice.tv_nsec >= 1000000000L) { slice.tv_sec++; slice.tv_nsec -= 1000000000L; }
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            pthread_mutex_lock(&game_state->player_mutex[p]);
+            m.player_rng[p] = game_state->player_rng[p];
+            m.player_draws[p] = game_state->player_draws[p];
+            memcpy(m.player_scores[p], game_state->player_scores[p], sizeof(m.player_scores[p]));
+            m.yahtzee_achieved[p] = game_state->yahtzee_achieved[p];
+            m.amount_yahtzee[p] = game_state->amount_yahtzee[p];
+            m.required_upper_section[p] = game_state->required_upper_section[p];
+            m.bonus_achieved[p] = game_state->bonus_achieved[p];
+            pthread_mutex_unlock(&game_state->player_mutex[p]);
+        }
+    }
+    pthread_mutex_unlock(&game_state->match_mutex);
 
-        int r = sem_timedwait(&game_state->turn_done_sem[pid], &slice);
-        if (r == 0) return 0;              
-        if (errno != ETIMEDOUT) return 0; 
+    if (ckpt_write(checkpoint, game_state->lobby_id, &m, sizeof(m)) < 0) {
+        perror("checkpoint write");
     }
 }
 
 
 // Endgame Logic
+//
+// *_nolock helpers expect match_mutex held; *_plocked helpers expect the
+// player's player_mutex held.
 
-static int player_finished_nolock(int pid) {
+static int player_finished_plocked(int pid) {
     int scored = 0;
     for (int c = 0; c < 13; c++) {
         if (game_state->player_scores[pid][c][1] == 1) scored++;
@@ -314,6 +556,7 @@ static void wake_all_players_nolock(void) {
             sem_post(&game_state->turn_sem[p]);
         }
     }
+    wake_sessions();
 }
 
 static void finalize_game_nolock(void) {
@@ -326,10 +569,13 @@ static void finalize_game_nolock(void) {
         if (!game_state->participants[p]) continue;
 
         // Ensure bonus is correct before totaling
-        maybe_award_upper_bonus_nolock(p);
+        pthread_mutex_lock(&game_state->player_mutex[p]);
+        maybe_award_upper_bonus_plocked(p);
 
         int total = 0;
         for (int i = 0; i < 15; i++) total += game_state->player_scores[p][i][0];
+        publish_player_plocked(p);
+        pthread_mutex_unlock(&game_state->player_mutex[p]);
 
         game_state->final_scores[p] = total;
 
@@ -338,17 +584,23 @@ static void finalize_game_nolock(void) {
 
     game_state->winner_id = best;
     game_state->game_finished = 1;
+    lobby_changed_nolock();
 
-    if (best >= 0) {
-        game_state->total_wins[best] += 1;
+    unsigned char rec[2 * MAX_PLAYERS + 1];
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        int16_t total = (int16_t)(game_state->participants[p] ? game_state->final_scores[p] : 0);
+        memcpy(rec + 2 * p, &total, 2);
+    }
+    rec[2 * MAX_PLAYERS] = (unsigned char)(signed char)best;
+    journal_event(JNL_END, 0, rec, sizeof(rec));
 
-        // Persist updated total wins
+    if (best >= 0) {
         char log_buf[128];
         snprintf(log_buf, sizeof(log_buf), "Game Over. Winner:Player %d (%s). Scores saved.\n", best + 1, game_state->player_names[best]);
         log_message(log_buf);
     }
 
-    save_scores_to_file();
+    record_results_nolock();
 
     wake_all_players_nolock();
 }
@@ -362,7 +614,11 @@ static void maybe_end_game_nolock(void) {
     for (int p = 0; p < MAX_PLAYERS; p++) {
         if (!game_state->participants[p]) continue;
 
-        if (player_finished_nolock(p)) game_state->player_done[p] = 1;
+        pthread_mutex_lock(&game_state->player_mutex[p]);
+        int finished = player_finished_plocked(p);
+        pthread_mutex_unlock(&game_state->player_mutex[p]);
+
+        if (finished) game_state->player_done[p] = 1;
         if (game_state->player_done[p]) done++;
     }
 
@@ -374,14 +630,19 @@ static void forfeit_remaining_on_disconnect_nolock(int player_id) {
     if (!game_state->participants[player_id]) return;
     if (game_state->player_done[player_id]) return;
 
+    journal_event(JNL_DISCONNECT, player_id, NULL, 0);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    game_state->turn_phase[player_id] = TURN_IDLE;
     for (int cat = 0; cat < 13; cat++) {
         if (game_state->player_scores[player_id][cat][1] == 0) {
             game_state->player_scores[player_id][cat][0] = 0;
             game_state->player_scores[player_id][cat][1] = 1;
         }
     }
-    update_section_flags_nolock(player_id);
-    maybe_award_upper_bonus_nolock(player_id);
+    update_section_flags_plocked(player_id);
+    maybe_award_upper_bonus_plocked(player_id);
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
 
     game_state->player_done[player_id] = 1;
     maybe_end_game_nolock();
@@ -390,41 +651,46 @@ static void forfeit_remaining_on_disconnect_nolock(int player_id) {
 
 // Timeout scoring 
 
-static int apply_zero_next_available_nolock(int player_id) {
+static int apply_zero_next_available_plocked(int player_id) {
     for (int cat = 0; cat < 13; cat++) {
         if (game_state->player_scores[player_id][cat][1] == 0) {
             game_state->player_scores[player_id][cat][0] = 0;
             game_state->player_scores[player_id][cat][1] = 1;
-            update_section_flags_nolock(player_id);
-            maybe_award_upper_bonus_nolock(player_id);
-            // NEW: after applying a score, check end condition
-            maybe_end_game_nolock();
+            update_section_flags_plocked(player_id);
+            maybe_award_upper_bonus_plocked(player_id);
             return cat;
         }
     }
     return -1;
 }
 
-static void forfeit_turn_timeout(int player_id, int write_fd) {
+// Auto-score the expired turn; the caller delivers `msg` to the player
+static void forfeit_turn_timeout(int player_id, char *msg, size_t msg_sz) {
     while (sem_trywait(&game_state->turn_done_sem[player_id]) == 0) {
     }
 
-    pthread_mutex_lock(&game_state->game_mutex);
-    int cat = apply_zero_next_available_nolock(player_id);
-    pthread_mutex_unlock(&game_state->game_mutex);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    game_state->turn_phase[player_id] = TURN_IDLE;
+    int cat = apply_zero_next_available_plocked(player_id);
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+    signed char rec = (signed char)cat;
+    journal_event(JNL_TIMEOUT, player_id, &rec, 1);
+
+    // after applying a score, check end condition
+    pthread_mutex_lock(&game_state->match_mutex);
+    maybe_end_game_nolock();
+    pthread_mutex_unlock(&game_state->match_mutex);
 
     if (cat >= 0) {
-        char msg[256];
-        snprintf(msg, sizeof(msg),
+        snprintf(msg, msg_sz,
                  "\n[TIMEOUT] 60 seconds expired. You forfeit this turn.\n"
                  "Auto-scored 0 in your next available category (category #%d).\n"
                  "Turn ended.\n\n", cat + 1);
-        write(write_fd, msg, strlen(msg));
     } else {
-        const char *msg =
-            "\n[TIMEOUT] 60 seconds expired. No categories left to score.\n"
-            "Turn ended.\n\n";
-        write(write_fd, msg, strlen(msg));
+        snprintf(msg, msg_sz,
+                 "\n[TIMEOUT] 60 seconds expired. No categories left to score.\n"
+                 "Turn ended.\n\n");
     }
 
     sem_post(&game_state->turn_done_sem[player_id]);
@@ -433,85 +699,72 @@ static void forfeit_turn_timeout(int player_id, int write_fd) {
 
 // Game logic
 
+// Headless simulation: no per-turn console output
+static int quiet;
+
 void roll_dice(int player_id) {
-    pthread_mutex_lock(&game_state->game_mutex);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
     for (int i = 0; i < 5; i++) {
-        game_state->player_dice[player_id][i] = rand() % 6 + 1;
+        game_state->player_dice[player_id][i] = rng_die(&game_state->player_rng[player_id]);
     }
-    pthread_mutex_unlock(&game_state->game_mutex);
-    printf("[GAME] Player %d rolled dice\n", player_id + 1);
+    game_state->player_draws[player_id] += 5;
+    game_state->turn_phase[player_id] = TURN_ROLLED;
+    unsigned char rec[5];
+    journal_dice(rec, player_id);
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+    journal_event(JNL_ROLL, player_id, rec, sizeof(rec));
+    if (!quiet) printf("[GAME] Player %d rolled dice\n", player_id + 1);
 
     char roll_msg[128];
     snprintf(roll_msg, sizeof(roll_msg), "Player %d rolled the dice.\n", player_id + 1);
     log_message(roll_msg);
 }
 
+// Reroll the chosen dice (1-based positions), using up one reroll
 void reroll_dice(int player_id, int dice_to_reroll[], int count) {
-    pthread_mutex_lock(&game_state->game_mutex);
+    unsigned char rec[11] = {0};           // count, positions in draw order, dice after
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
     for (int i = 0; i < count; i++) {
         int idx = dice_to_reroll[i] - 1;
         if (idx >= 0 && idx < 5) {
-            game_state->player_dice[player_id][idx] = rand() % 6 + 1;
+            game_state->player_dice[player_id][idx] = rng_die(&game_state->player_rng[player_id]);
+            game_state->player_draws[player_id]++;
+            if (rec[0] < 5) rec[1 + rec[0]++] = (unsigned char)idx;
         }
     }
-    pthread_mutex_unlock(&game_state->game_mutex);
+    game_state->player_rerolls_left[player_id]--;
+    journal_dice(rec + 6, player_id);
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+    journal_event(JNL_REROLL, player_id, rec, sizeof(rec));
 }
 
 void calculate_possible_scores(int player_id) {
     int dice[5];
+    int scores[SCORING_NUM_CATEGORIES];
 
-    pthread_mutex_lock(&game_state->game_mutex);
-
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
     for (int i = 0; i < 5; i++) dice[i] = game_state->player_dice[player_id][i];
-    qsort(dice, 5, sizeof(int), compare_int);
-
-    for (int i = 0; i < 15; i++) game_state->player_scores[player_id][i][2] = 0;
+    int joker = (game_state->yahtzee_achieved[player_id] == 'Y');
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
 
-    for (int i = 0; i < 5; i++) {
-        if (dice[i] == 1) game_state->player_scores[player_id][0][2] += 1;
-        if (dice[i] == 2) game_state->player_scores[player_id][1][2] += 2;
-        if (dice[i] == 3) game_state->player_scores[player_id][2][2] += 3;
-        if (dice[i] == 4) game_state->player_scores[player_id][3][2] += 4;
-        if (dice[i] == 5) game_state->player_scores[player_id][4][2] += 5;
-        if (dice[i] == 6) game_state->player_scores[player_id][5][2] += 6;
-    }
-
-    if (has_n_of_a_kind(dice, 3)) {
-        int sum = 0;
-        for (int i = 0; i < 5; i++) sum += dice[i];
-        game_state->player_scores[player_id][6][2] = sum;
-    }
+    // One table lookup yields every category, so the lock only covers the copy-out
+    scoring_possible_scores(scoring_roll_index(dice), joker, scores);
 
-    if (has_n_of_a_kind(dice, 4)) {
-        int sum = 0;
-        for (int i = 0; i < 5; i++) sum += dice[i];
-        game_state->player_scores[player_id][7][2] = sum;
-    }
-
-    if (is_full_house(dice)) game_state->player_scores[player_id][8][2] = 25;
-    if (has_small_straight(dice)) game_state->player_scores[player_id][9][2] = 30;
-    if (has_large_straight(dice)) game_state->player_scores[player_id][10][2] = 40;
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    for (int i = 0; i < SCORING_NUM_CATEGORIES; i++)
+        game_state->player_scores[player_id][i][2] = scores[i];
+    game_state->player_scores[player_id][13][2] = 0;
+    game_state->player_scores[player_id][14][2] = 0;
 
-    if (has_n_of_a_kind(dice, 5)) {
-        game_state->player_scores[player_id][11][2] = 50;
+    if (scores[CAT_YAHTZEE] == 50) {
         game_state->required_upper_section[player_id] = dice[0] - 1; // 0..5
     }
-
-    int sum = 0;
-    for (int i = 0; i < 5; i++) sum += dice[i];
-    game_state->player_scores[player_id][12][2] = sum;
-
-    if (game_state->yahtzee_achieved[player_id] == 'Y' &&
-        game_state->player_scores[player_id][11][2] == 50) {
-        game_state->player_scores[player_id][8][2]  = 25;
-        game_state->player_scores[player_id][9][2]  = 30;
-        game_state->player_scores[player_id][10][2] = 40;
-    }
-
-    pthread_mutex_unlock(&game_state->game_mutex);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
 }
 
-static void update_section_flags_nolock(int player_id) {
+static void update_section_flags_plocked(int player_id) {
     int c = 0;
     for (int i = 0; i < 6; i++) if (game_state->player_scores[player_id][i][1] == 1) c++;
     game_state->upper_section_filled[player_id] = (c == 6) ? 'Y' : 'N';
@@ -521,7 +774,7 @@ static void update_section_flags_nolock(int player_id) {
     game_state->lower_section_filled[player_id] = (c == 7) ? 'Y' : 'N';
 }
 
-static int maybe_award_upper_bonus_nolock(int player_id) {
+static int maybe_award_upper_bonus_plocked(int player_id) {
     if (game_state->bonus_achieved[player_id] == 'Y') return 0;
 
     int upper_total = 0;
@@ -537,10 +790,10 @@ static int maybe_award_upper_bonus_nolock(int player_id) {
 }
 
 int apply_score(int player_id, int category) {
-    pthread_mutex_lock(&game_state->game_mutex);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
 
     if (category < 0 || category >= 13 || game_state->player_scores[player_id][category][1] == 1) {
-        pthread_mutex_unlock(&game_state->game_mutex);
+        pthread_mutex_unlock(&game_state->player_mutex[player_id]);
         return 0;
     }
 
@@ -551,158 +804,131 @@ int apply_score(int player_id, int category) {
         game_state->yahtzee_achieved[player_id] = 'Y';
     }
 
-    update_section_flags_nolock(player_id);
-    maybe_award_upper_bonus_nolock(player_id);
+    update_section_flags_plocked(player_id);
+    maybe_award_upper_bonus_plocked(player_id);
+    int points = game_state->player_scores[player_id][category][0];
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+    journal_score(player_id, category, 0, points);
 
     // Check endgame right after scoring
+    pthread_mutex_lock(&game_state->match_mutex);
     maybe_end_game_nolock();
+    pthread_mutex_unlock(&game_state->match_mutex);
 
     char score_msg[128];
-    snprintf(score_msg, sizeof(score_msg), "Player %d succesfully scored %d points in category %d.\n", player_id + 1, game_state->player_scores[player_id][category][0], category + 1);
+    snprintf(score_msg, sizeof(score_msg), "Player %d succesfully scored %d points in category %d.\n", player_id + 1, points, category + 1);
     log_message(score_msg);
 
-    pthread_mutex_unlock(&game_state->game_mutex);
     return 1;
 }
 
 int calculate_total_score(int player_id) {
     int total = 0;
 
-    pthread_mutex_lock(&game_state->game_mutex);
-    maybe_award_upper_bonus_nolock(player_id);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    maybe_award_upper_bonus_plocked(player_id);
     for (int i = 0; i < 15; i++) total += game_state->player_scores[player_id][i][0];
-    pthread_mutex_unlock(&game_state->game_mutex);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
 
     return total;
 }
 
-void save_scores_to_file() {
-    int fd = open("scores.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        log_message("Error opening scores.txt for writing\n");
-        return;
+// Republish the leaderboard's top entries. Games finish in several lobbies
+// (and processes) at once, so leaders_mutex serializes the seqlock writers;
+// it nests inside match_mutex and outside the store's own lock.
+static void publish_leaders(void) {
+    if (!snap_arena || !score_store) return;
+
+    LeaderEntry top[SNAP_LEADERS];
+    SnapLeaders *sl = &snap_arena->leaders;
+
+    pthread_mutex_lock(&arena->leaders_mutex);
+    int n = store_top(score_store, top, SNAP_LEADERS);
+    uint32_t players = store_count(score_store);
+
+    seqlock_write_begin(&sl->seq);
+    sl->players = players;
+    sl->count = n;
+    for (int i = 0; i < n; i++) {
+        memcpy(sl->top[i].name, top[i].name, SNAP_NAME_SIZE - 1);
+        sl->top[i].name[SNAP_NAME_SIZE - 1] = '\0';
+        sl->top[i].wins        = top[i].stats.wins;
+        sl->top[i].games       = top[i].stats.games;
+        sl->top[i].high_score  = top[i].stats.high_score;
+        sl->top[i].total_score = top[i].stats.total_score;
     }
+    seqlock_write_end(&sl->seq);
+    pthread_mutex_unlock(&arena->leaders_mutex);
+}
 
-    flock(fd, LOCK_EX);
-
+// Persistent stats live in scores.db (see store.h). Each finished game
+// updates only its own participants' records in place.
+static void record_results_nolock(void) {
+    if (!score_store) return;
     for (int p = 0; p < MAX_PLAYERS; p++) {
-
-        // Skip the slots for empty players
-        if (game_state->player_names[p][0] == '\0')
-            continue;
-
-        char buf[256];
-        snprintf(buf, sizeof(buf), "%s:%d\n",
-                 game_state->player_names[p],
-                 game_state->total_wins[p]);
-
-        write(fd, buf, strlen(buf));
+        if (!game_state->participants[p] || game_state->player_names[p][0] == '\0') continue;
+        if (game_state->player_bot[p]) continue;        // bots stay off the leaderboard
+        if (store_record_game(score_store, game_state->player_names[p],
+                              game_state->final_scores[p], p == game_state->winner_id) < 0) {
+            log_message("Error updating scores.db\n");
+        }
     }
-
-    flock(fd, LOCK_UN);
-    close(fd);
-    log_message("Scores saved to scores.txt\n");
+    publish_leaders();
 }
 
 
-void load_scores_from_file() {
-    int fd = open("scores.txt", O_RDONLY);
+// Carry win counts over from the old "name:wins" scores.txt into a new store
+static void import_legacy_win(const char *name, int wins, void *ctx) {
+    store_set_wins((Store*)ctx, name, (uint32_t)wins);
+}
+
+static void import_legacy_scores(void) {
+    int fd = open(LEGACY_SCORES, O_RDONLY);
     if (fd < 0) {
         log_message("scores.txt not found, starting fresh\n");
         return;
     }
     flock(fd, LOCK_SH);
-    char buf[BUFFER_SIZE];
-    ssize_t n;
-    while ((n = read(fd, buf, sizeof(buf) - 1)) > 0) {
-        buf[n] = '\0';
-        char *line = strtok(buf, "\n");
-        while (line) {
-            char name[NAME_SIZE];
-            int wins;
-            if (sscanf(line, "%[^:]:%d", name, &wins) == 2) {
-                for (int p = 0; p < MAX_PLAYERS; p++) {
-                    if (strcmp(game_state->player_names[p], name) == 0) {
-                        game_state->total_wins[p] = wins;
-                        break;
-                    }
-                }
-            }
-            line = strtok(NULL, "\n");
-        }
-    }
+    store_import_begin(score_store);
+    long records = scorefile_parse(fd, import_legacy_win, score_store);
+    int err = errno;
+    store_import_end(score_store);
     flock(fd, LOCK_UN);
     close(fd);
-    log_message("Scores loaded from scores.txt\n");
-}
-
 
-// Load existing wins from scores.txt when rematch
-static int lookup_wins_for_name(const char *name) {
-    int fd = open("scores.txt", O_RDONLY);
-    if (fd < 0) return 0;
-
-    flock(fd, LOCK_SH);
-
-    char buf[BUFFER_SIZE];
-    ssize_t n;
-    int wins = 0;
-
-    while ((n = read(fd, buf, sizeof(buf) - 1)) > 0) {
-        buf[n] = '\0';
-        char *line = strtok(buf, "\n");
-        while (line) {
-            char file_name[NAME_SIZE];
-            int file_wins;
-            if (sscanf(line, "%49[^:]:%d", file_name, &file_wins) == 2) {
-                if (strcmp(file_name, name) == 0) wins = file_wins;
-            }
-            line = strtok(NULL, "\n");
-        }
+    char msg[128];
+    if (records < 0) {
+        snprintf(msg, sizeof(msg), "Error reading scores.txt: %s\n", strerror(err));
+    } else {
+        snprintf(msg, sizeof(msg), "Imported %ld records (%u players) from scores.txt\n",
+                 records, store_count(score_store));
     }
-
-    flock(fd, LOCK_UN);
-    close(fd);
-    return wins;
+    log_message(msg);
 }
 
 
 // Shared Memory 
 
-int init_shared_memory() {
-    shm_unlink("/yahtzee_shm");
-
-    int shm_fd = shm_open("/yahtzee_shm", O_CREAT | O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("shm_open failed");
-        return -1;
-    }
-
-    if (ftruncate(shm_fd, sizeof(GameState)) == -1) {
-        perror("ftruncate failed");
-        close(shm_fd);
-        return -1;
-    }
-
-    game_state = (GameState*) mmap(NULL, sizeof(GameState),
-                                   PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (game_state == MAP_FAILED) {
-        perror("mmap failed");
-        close(shm_fd);
-        return -1;
-    }
-
+static void init_lobby_state(int lobby_id) {
     memset(game_state, 0, sizeof(GameState));
+    game_state->lobby_id = lobby_id;
 
     pthread_mutexattr_t mutex_attr;
     pthread_mutexattr_init(&mutex_attr);
     pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
 
-    pthread_mutex_init(&game_state->game_mutex, &mutex_attr);
-    pthread_mutex_init(&game_state->log_mutex, &mutex_attr);
+    pthread_mutex_init(&game_state->match_mutex, &mutex_attr);
+    for (int i = 0; i < MAX_PLAYERS; i++) pthread_mutex_init(&game_state->player_mutex[i], &mutex_attr);
 
     pthread_mutexattr_destroy(&mutex_attr);
 
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&game_state->lobby_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
     for (int i = 0; i < MAX_PLAYERS; i++) {
         sem_init(&game_state->turn_sem[i], 1, 0);
         sem_init(&game_state->turn_done_sem[i], 1, 0);
@@ -714,9 +940,6 @@ int init_shared_memory() {
 
     }
 
-    sem_init(&log_items_sem, 0, 0);
-    sem_init(&log_slots_sem, 0, LOG_QUEUE_SIZE);
-
     game_state->current_turn   = 0;
     game_state->active_players = 0;
     game_state->target_players = 0;
@@ -735,7 +958,6 @@ int init_shared_memory() {
 
     for (int i = 0; i < MAX_PLAYERS; i++) {
         game_state->player_connected[i] = 0;
-        game_state->total_wins[i] = 0;
 
         game_state->yahtzee_achieved[i] = 'N';
         game_state->amount_yahtzee[i] = 0;
@@ -754,33 +976,77 @@ int init_shared_memory() {
             }
         }
     }
+}
+
+int init_shared_memory(int num_lobbies) {
+    shm_unlink("/yahtzee_shm");
+
+    int shm_fd = shm_open("/yahtzee_shm", O_CREAT | O_RDWR, 0666);
+    if (shm_fd == -1) {
+        perror("shm_open failed");
+        return -1;
+    }
+
+    arena_size = sizeof(ServerArena) + (size_t)num_lobbies * sizeof(GameState);
+
+    if (ftruncate(shm_fd, (off_t)arena_size) == -1) {
+        perror("ftruncate failed");
+        close(shm_fd);
+        return -1;
+    }
+
+    arena = (ServerArena*) mmap(NULL, arena_size,
+                                PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (arena == MAP_FAILED) {
+        perror("mmap failed");
+        close(shm_fd);
+        return -1;
+    }
+    close(shm_fd);
+
+    snap_arena = snapshot_create(num_lobbies);
+    if (!snap_arena) perror("snapshot shm (spectator view disabled)");
+
+    arena->num_lobbies = num_lobbies;
+
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&arena->leaders_mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    for (int l = 0; l < num_lobbies; l++) {
+        game_state = &arena->lobbies[l];
+        init_lobby_state(l);
+    }
+    game_state = NULL;
+
+    if (init_log_ring() < 0) return -1;
 
-    printf("✓ Shared memory initialized (fresh)\n");
+    printf("✓ Shared memory initialized (fresh, %d lobbies)\n", num_lobbies);
     return 0;
 }
 
 // SIGCHLD 
 
-void sigchld_handler(int sig) {
-    (void)sig;
-    int saved_errno = errno;
-    pid_t pid;
-    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
-        printf("[SYSTEM] Child process %d reaped\n", pid);
+// SIGCHLD is delivered through a signalfd so the main loop can reap children
+// as an event. Must run before any thread is created so they all inherit the mask.
+int setup_signal_handlers() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) {
+        perror("pthread_sigmask failed");
+        exit(1);
     }
-    errno = saved_errno;
-}
 
-void setup_signal_handlers() {
-    struct sigaction sa;
-    sa.sa_handler = sigchld_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
-    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
-        perror("sigaction failed");
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd == -1) {
+        perror("signalfd failed");
         exit(1);
     }
     printf("✓ Signal handlers set up\n");
+    return sfd;
 }
 
 // IPC setup
@@ -805,23 +1071,25 @@ int setup_ipc_server() {
 }
 
 static void reject_client(const char* client_fifo, const char* msg) {
-    char client_read_fifo[256];
+    char client_read_fifo[256 + 8];
     snprintf(client_read_fifo, sizeof(client_read_fifo), "%s_read", client_fifo);
 
     int wfd = open(client_fifo, O_WRONLY);
     int rfd = open(client_read_fifo, O_RDONLY);
 
     if (wfd >= 0) {
-        write(wfd, msg, strlen(msg));
+        ProtoMsg m;
+        proto_begin(&m, MSG_REJECT);
+        proto_put_str(&m, msg);
+        size_t len = proto_end(&m);
+        if (len) write(wfd, m.data, len);
         close(wfd);
     }
     if (rfd >= 0) close(rfd);
 }
 
-// Client Handler 
-static void child_mark_disconnect_and_exit(int player_id, int write_fd, int read_fd) {
-    pthread_mutex_lock(&game_state->game_mutex);
-
+// Client Handler
+static void mark_disconnected_nolock(int player_id) {
     // mark disconnected and maintain active_players
     if (game_state->player_connected[player_id]) {
         game_state->player_connected[player_id] = 0;
@@ -829,669 +1097,2617 @@ static void child_mark_disconnect_and_exit(int player_id, int write_fd, int read
     }
     game_state->child_pid[player_id] = -1;
 
-    // if this player is part of an active match, force-forfeit them
-    if (game_state->game_started &&
+    // A player in an active match keeps the seat for a while to come back
+    // to with the seat token (the scheduler skips it meanwhile and forfeits
+    // it when the hold runs out); without a token they forfeit at once
+    if (game_state->game_started && !game_state->game_finished &&
         game_state->participants[player_id] &&
         !game_state->player_done[player_id]) {
 
-        forfeit_remaining_on_disconnect_nolock(player_id);
+        if (game_state->seat_token[player_id] != 0) {
+            clock_gettime(CLOCK_REALTIME, &game_state->reserve_until[player_id]);
+            game_state->reserve_until[player_id].tv_sec += RECONNECT_GRACE_SECONDS;
+
+            char msg[128];
+            snprintf(msg, sizeof(msg), "Player %d disconnected, seat held for %ds\n",
+                     player_id + 1, RECONNECT_GRACE_SECONDS);
+            log_message(msg);
+        } else {
+            forfeit_remaining_on_disconnect_nolock(player_id);
+        }
     }
 
-    pthread_mutex_unlock(&game_state->game_mutex);
+    lobby_changed_nolock();
+}
+
+static void release_disconnected_player(int player_id) {
+    pthread_mutex_lock(&game_state->match_mutex);
+    mark_disconnected_nolock(player_id);
+    pthread_mutex_unlock(&game_state->match_mutex);
 
     // unblock scheduler if it was waiting on this player's slice
     sem_post(&game_state->turn_done_sem[player_id]);
+}
+
+static void child_mark_disconnect_and_exit(int player_id, int write_fd, int read_fd) {
+    release_disconnected_player(player_id);
 
     if (write_fd >= 0) close(write_fd);
     if (read_fd  >= 0) close(read_fd);
     _exit(0);
 }
 
-void handle_client(int player_id, const char* client_fifo) {
-    // allow scheduler to force-end this player's turn on quantum expiry
-    g_child_player_id = player_id;
-    {
-        struct sigaction sa2;
-        memset(&sa2, 0, sizeof(sa2));
-        sa2.sa_handler = sigusr1_handler;
-        sigemptyset(&sa2.sa_mask);
-        sa2.sa_flags = 0; 
-        sigaction(SIGUSR1, &sa2, NULL);
-    }
-    
-    char buffer[BUFFER_SIZE];
-    char recv_buffer[256];
-    char client_read_fifo[256];
-
-    snprintf(client_read_fifo, sizeof(client_read_fifo), "%s_read", client_fifo);
 
-    int write_fd = open(client_fifo, O_WRONLY);
-    int read_fd  = open(client_read_fifo, O_RDONLY);
+// Client Sessions
+//
+// A session is one player's conversation with the server written as a state
+// machine. session_step() advances it until it has to wait for client input,
+// for the lobby to change or for the scheduler to grant a turn, and reports
+// which of those it needs. In fork mode a child process drives one session
+// with blocking waits; in pool mode a reactor thread and a fixed set of
+// worker threads drive every session inside the server process.
+
+#define SESSION_INBUF 512
+#define SESSION_OUTBUF 16384
+
+typedef enum {
+    SESS_OPEN,          // client FIFOs not opened yet
+    SESS_NAME,          // "Enter your name"
+    SESS_HOST_SETUP,    // host chooses number of players
+    SESS_HOST_BOTS,     // host chooses whether bots fill the empty seats
+    SESS_WAIT_TARGET,   // waiting for the host
+    SESS_WAIT_START,    // waiting for the match to start
+    SESS_REJOIN,        // took a held seat back: show where the match stands
+    SESS_WAIT_TURN,     // waiting for the scheduler
+    SESS_REROLL,        // "Reroll? (Y/N)"
+    SESS_WHICH_DICE,    // "Which dice?"
+    SESS_CATEGORY,      // "Choose category"
+    SESS_DONE
+} SessionState;
+
+typedef enum {
+    SESSION_WAIT_INPUT,     // needs a line from the client (turn deadline applies)
+    SESSION_WAIT_LOBBY,     // needs lobby_gen to move
+    SESSION_WAIT_TURN,      // needs turn_sem
+    SESSION_DONE            // finished or disconnected
+} SessionWait;
+
+typedef struct Session {
+    GameState *gs;
+    int player_id;
+    char client_fifo[256];
+    int write_fd;
+    int read_fd;
 
-    if (write_fd < 0 || read_fd < 0) {
-        perror("open FIFOs failed");
-        exit(1);
-    }
+    // Optional shared-memory transport; the FIFOs then only carry the
+    // handshake and signal hangups
+    char ring_name[RING_NAME_SIZE];
+    RingSegment *ring;
+
+    SessionState state;
+    int in_turn;
+    struct timespec deadline;
+    int turn_granted;
+    unsigned lobby_gen;
+    int disconnected;
+    int left_out;                   // not picked for the match that started
+    int rejoin;                     // reclaimed a held seat with its token
+
+    char inbuf[SESSION_INBUF];
+    size_t inlen;
+    int eof;
+
+    // A whole screen is gathered here and sent with one write when the
+    // session next waits (prompt boundaries, end of turn, lobby waits)
+    char outbuf[SESSION_OUTBUF];
+    size_t outlen;
+
+    unsigned long io_calls;         // read/write/poll/futex calls made for this session
+    unsigned long turn_io_mark;     // io_calls when the current turn started
+
+    // Scorecard state at the start of this turn and the points already
+    // banked, so hints can turn expected future points into a final score
+    SolverState hint_state;
+    int hint_base;
+
+    // Server-run player: input comes from the bot, output goes nowhere
+    Bot *bot;
+    int bot_hold;                   // hold mask decided at the reroll prompt
+
+    // pool mode bookkeeping (guarded by the pool mutex)
+    int slot;
+    uint32_t serial;
+    SessionWait wait;
+    int registered;
+    int queued;
+    int running;
+    int rerun;
+    struct Session *next_ready;
+} Session;
+
+static Session* session_create(GameState *gs, int player_id, const char *client_fifo,
+                               const char *ring_name) {
+    Session *s = (Session*)calloc(1, sizeof(Session));
+    if (!s) return NULL;
+    s->gs = gs;
+    s->player_id = player_id;
+    snprintf(s->client_fifo, sizeof(s->client_fifo), "%s", client_fifo);
+    snprintf(s->ring_name, sizeof(s->ring_name), "%s", ring_name ? ring_name : "");
+    s->write_fd = -1;
+    s->read_fd  = -1;
+    s->state = SESS_OPEN;
+    s->slot = -1;
+    return s;
+}
 
-    // watchdog to detect client disconnect even while blocked
-    WatchArgs *wa = (WatchArgs*)malloc(sizeof(*wa));
-    if (!wa) {
-        perror("malloc watchdog");
-        child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
+static void session_send_now(Session *s, const char *buf, size_t len) {
+    if (s->ring) {
+        unsigned long before = ring_syscalls();
+        ring_write(&s->ring->to_client, buf, len);
+        s->io_calls += ring_syscalls() - before;
+        return;
     }
-    wa->player_id = player_id;
-    wa->read_fd   = read_fd;
-    wa->write_fd  = write_fd;
-    pthread_t wd_tid;
-    pthread_create(&wd_tid, NULL, disconnect_watchdog, wa);
-    pthread_detach(wd_tid);
-
-    snprintf(buffer, sizeof(buffer), "Enter your name: ");
-    write(write_fd, buffer, strlen(buffer));
-
-    int n = read(read_fd, recv_buffer, sizeof(recv_buffer) - 1);
-    if (n <= 0) child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
-    if (n > 0) {
-        recv_buffer[n] = '\0';
-        recv_buffer[strcspn(recv_buffer, "\n")] = '\0';
-        pthread_mutex_lock(&game_state->game_mutex);
-        strncpy(game_state->player_names[player_id], recv_buffer, NAME_SIZE - 1);
+    if (s->write_fd < 0) return;
+    ssize_t r = write(s->write_fd, buf, len);
+    (void)r;
+    s->io_calls++;
+}
 
-        char join_msg[128];
-        snprintf(join_msg, sizeof(join_msg), "Player %d identified as %s\n", player_id + 1, game_state->player_names[player_id]);
-        log_message(join_msg);
-        pthread_mutex_unlock(&game_state->game_mutex);
+static void session_flush(Session *s) {
+    if (s->outlen == 0) return;
+    session_send_now(s, s->outbuf, s->outlen);
+    s->outlen = 0;
+}
 
-        // Restore wins for this name
-        int restored = lookup_wins_for_name(game_state->player_names[player_id]);
-        pthread_mutex_lock(&game_state->game_mutex);
-        game_state->total_wins[player_id] = restored;
-        pthread_mutex_unlock(&game_state->game_mutex);
+static void session_write(Session *s, const char *buf, size_t len) {
+    if (s->outlen + len > sizeof(s->outbuf)) session_flush(s);
+    if (len > sizeof(s->outbuf)) {
+        session_send_now(s, buf, len);
+        return;
     }
+    memcpy(s->outbuf + s->outlen, buf, len);
+    s->outlen += len;
+}
 
-    snprintf(buffer, sizeof(buffer), "Welcome %s! You are Player %d\n",
-             game_state->player_names[player_id], player_id + 1);
-    write(write_fd, buffer, strlen(buffer));
+static void session_send(Session *s, ProtoMsg *m) {
+    if (s->bot) return;                 // nobody to read it
+    size_t len = proto_end(m);
+    if (len) session_write(s, (const char*)m->data, len);
+}
 
-    pthread_mutex_lock(&game_state->game_mutex);
-    if (game_state->host_player_id < 0) game_state->host_player_id = player_id;
-    int host_id = game_state->host_player_id;
-    pthread_mutex_unlock(&game_state->game_mutex);
+// Free-form text goes out as a MSG_TEXT frame
+static void session_printf(Session *s, const char *fmt, ...) {
+    if (s->bot) return;
+    char buffer[BUFFER_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buffer, sizeof(buffer), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(buffer)) n = (int)sizeof(buffer) - 1;
+
+    ProtoMsg m;
+    proto_begin(&m, MSG_TEXT);
+    proto_put_bytes(&m, buffer, (size_t)n);
+    session_send(s, &m);
+}
 
-    if (player_id == host_id) {
-        while (1) {
-            pthread_mutex_lock(&game_state->game_mutex);
-            int target = game_state->target_players;
-            int connected = game_state->active_players;
-            pthread_mutex_unlock(&game_state->game_mutex);
+static void session_prompt(Session *s, PromptKind kind, int min, int max) {
+    ProtoMsg m;
+    proto_begin(&m, MSG_PROMPT);
+    proto_put_u8(&m, kind);
+    proto_put_u8(&m, min);
+    proto_put_u8(&m, max);
+    proto_put_u8(&m, game_state->player_rerolls_left[s->player_id]);
+    session_send(s, &m);
+}
 
-            if (target > 0) break;
+static int session_open(Session *s) {
+    char client_read_fifo[sizeof(s->client_fifo) + 8];
+    snprintf(client_read_fifo, sizeof(client_read_fifo), "%s_read", s->client_fifo);
 
-            snprintf(buffer, sizeof(buffer),
-                     "\n[HOST SETUP] Enter number of players for this game (3-%d): ",
-                     MAX_PLAYERS);
-            write(write_fd, buffer, strlen(buffer));
+    // Clients let in from the waiting room come with their FIFOs open
+    if (s->write_fd < 0) s->write_fd = open(s->client_fifo, O_WRONLY);
+    if (s->read_fd < 0) s->read_fd = open(client_read_fifo, O_RDONLY);
 
-            n = read(read_fd, recv_buffer, sizeof(recv_buffer) - 1);
-            if (n <= 0) child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
+    if (s->write_fd < 0 || s->read_fd < 0) return -1;
 
-            recv_buffer[n] = '\0';
-            int t = atoi(recv_buffer);
+    // Transport negotiation: MSG_HELLO always goes over the FIFO and says
+    // whether the requested rings were accepted. Pool mode cannot park a
+    // reactor on a futex, so it stays on the pipes.
+    if (s->ring_name[0] != '\0' && !pool_mode) s->ring = ring_segment_attach(s->ring_name);
 
-            if (t >= 3 && t <= MAX_PLAYERS) {
-                pthread_mutex_lock(&game_state->game_mutex);
-                game_state->target_players = t;
-                pthread_mutex_unlock(&game_state->game_mutex);
+    ProtoMsg hello;
+    proto_begin(&hello, MSG_HELLO);
+    proto_put_u8(&hello, s->ring != NULL);
+    proto_put_u8(&hello, s->rejoin);
+    size_t len = proto_end(&hello);
+    ssize_t r = write(s->write_fd, hello.data, len);
+    (void)r;
 
-                snprintf(buffer, sizeof(buffer),
-                         "✓ Lobby set to %d players. Currently connected: %d/%d\n"
-                         "Waiting for remaining players to join...\n",
-                         t, connected, t);
-                write(write_fd, buffer, strlen(buffer));
-                break;
-            } else {
-                snprintf(buffer, sizeof(buffer),
-                         "Invalid number. Please enter a value between 3 and %d.\n",
-                         MAX_PLAYERS);
-                write(write_fd, buffer, strlen(buffer));
+    if (s->rejoin) {
+        s->state = SESS_REJOIN;
+        return 0;
+    }
+    session_prompt(s, PROMPT_NAME, 0, 0);
+    s->state = SESS_NAME;
+    return 0;
+}
+
+// Pull whatever the client has sent into the session buffer.
+// Returns bytes read, 0 on hangup, -1 when nothing was available.
+static int session_fill_input(Session *s) {
+    size_t room = sizeof(s->inbuf) - s->inlen;
+    if (room == 0) return -1;
+
+    ssize_t n;
+    if (s->ring) {
+        unsigned long before = ring_syscalls();
+        n = ring_read(&s->ring->to_server, s->inbuf + s->inlen, room);
+        s->io_calls += ring_syscalls() - before;
+    } else {
+        n = read(s->read_fd, s->inbuf + s->inlen, room);
+        s->io_calls++;
+    }
+    if (n > 0) {
+        s->inlen += (size_t)n;
+        return (int)n;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return -1;
+
+    s->eof = 1;
+    return 0;
+}
+
+// 1 = line copied (newline kept), 0 = need more input, -1 = client hung up
+static int session_take_line(Session *s, char *line, size_t sz) {
+    char *nl = memchr(s->inbuf, '\n', s->inlen);
+    size_t len;
+
+    if (nl) {
+        len = (size_t)(nl - s->inbuf) + 1;
+    } else if (s->inlen == sizeof(s->inbuf) || (s->eof && s->inlen > 0)) {
+        len = s->inlen;
+    } else {
+        return s->eof ? -1 : 0;
+    }
+
+    size_t copy = (len < sz - 1) ? len : sz - 1;
+    memcpy(line, s->inbuf, copy);
+    line[copy] = '\0';
+
+    memmove(s->inbuf, s->inbuf + len, s->inlen - len);
+    s->inlen -= len;
+    return 1;
+}
+
+// Flush the turn's last screen and publish what the turn cost in syscalls
+static void session_account_turn(Session *s) {
+    session_flush(s);
+    int used = (int)(s->io_calls - s->turn_io_mark);
+
+    pthread_mutex_lock(&game_state->match_mutex);
+    game_state->turn_syscalls[s->player_id] = used;
+    game_state->io_syscalls_total += (unsigned long)used;
+    game_state->io_turns++;
+    pthread_mutex_unlock(&game_state->match_mutex);
+}
+
+static int session_turn_expired(Session *s) {
+    if (game_state->force_end_turn[s->player_id]) return 1;
+    return ms_until_deadline(&s->deadline) <= 0;
+}
+
+// A bot's answer to the prompt of the current state, as a client would type it
+static int session_bot_line(Session *s, char *line, size_t sz) {
+    int player_id = s->player_id;
+    const int *dice = game_state->player_dice[player_id];
+
+    switch (s->state) {
+    case SESS_REROLL:
+        s->bot_hold = bot_choose_hold(s->bot, &strategy, &s->hint_state, dice,
+                                      game_state->player_rerolls_left[player_id]);
+        snprintf(line, sz, "%s\n", s->bot_hold == REROLL_HOLD_ALL ? "N" : "Y");
+        break;
+
+    case SESS_WHICH_DICE: {
+        int len = 0;
+        for (int i = 0; i < 5; i++) {
+            if (!(s->bot_hold & (1 << i))) len += snprintf(line + len, sz - len, "%d ", i + 1);
+        }
+        snprintf(line + len, sz - len, "\n");
+        break;
+    }
+
+    case SESS_CATEGORY: {
+        int points[SCORING_NUM_CATEGORIES], allowed = 0;
+        int first = (game_state->lower_section_only[player_id] == 'N') ? 0 : 6;
+        for (int c = 0; c < SCORING_NUM_CATEGORIES; c++) {
+            points[c] = game_state->player_scores[player_id][c][2];
+            if (c >= first && game_state->player_scores[player_id][c][1] == 0) allowed |= 1 << c;
+        }
+        int cat = bot_choose_category(s->bot, &strategy, &s->hint_state, dice, points, allowed);
+        snprintf(line, sz, "%d\n", cat + 1);
+        break;
+    }
+
+    default:
+        snprintf(line, sz, "\n");
+        break;
+    }
+    return 1;
+}
+
+// Next line for the prompt of the current state.
+// 1 = line ready, 0 = wait for input, -1 = hung up, 2 = turn timed out (state changed)
+static int session_input(Session *s, char *line, size_t sz) {
+    if (s->in_turn && session_turn_expired(s)) {
+        char msg[256];
+        forfeit_turn_timeout(s->player_id, msg, sizeof(msg));
+        session_printf(s, "%s", msg);
+        session_account_turn(s);
+        s->in_turn = 0;
+        s->state = SESS_WAIT_TURN;
+        return 2;
+    }
+    if (s->bot) return session_bot_line(s, line, sz);
+    return session_take_line(s, line, sz);
+}
+
+static SessionWait session_hangup(Session *s) {
+    s->disconnected = 1;
+    s->state = SESS_DONE;
+    return SESSION_DONE;
+}
+
+static void session_show_dice(Session *s, DiceLabel label) {
+    ProtoMsg m;
+    proto_begin(&m, MSG_DICE);
+    proto_put_u8(&m, label);
+    for (int i = 0; i < 5; i++) proto_put_u8(&m, game_state->player_dice[s->player_id][i]);
+    session_send(s, &m);
+}
+
+static void session_prompt_reroll(Session *s) {
+    session_prompt(s, PROMPT_REROLL, 0, 0);
+    s->state = SESS_REROLL;
+}
+
+static void session_prompt_category(Session *s) {
+    int first = (game_state->lower_section_only[s->player_id] == 'N') ? 1 : 7;
+    session_prompt(s, PROMPT_CATEGORY, first, 13);
+    s->state = SESS_CATEGORY;
+}
+
+// Hints
+
+// "?" or "hint" at any turn prompt
+static int is_hint_request(const char *line) {
+    while (*line == ' ') line++;
+    if (line[0] == '?') return 1;
+    return strncasecmp(line, "hint", 4) == 0;
+}
+
+// Called as the turn starts: snapshot the scorecard into a solver state and
+// post it so the hint worker evaluates the turn while the player thinks
+static void session_post_hint_state(Session *s) {
+    int player_id = s->player_id;
+    SolverState *st = &s->hint_state;
+    int used = 0, upper = 0, banked = 0;
+
+    for (int c = 0; c < 13; c++) {
+        if (game_state->player_scores[player_id][c][1] != 1) continue;
+        used |= 1 << c;
+        if (c < 6) upper += game_state->player_scores[player_id][c][0];
+    }
+    for (int i = 0; i < 15; i++) banked += game_state->player_scores[player_id][i][0];
+
+    st->used = (uint16_t)used;
+    st->upper = (uint8_t)(upper > SOLVER_UPPER_CAP ? SOLVER_UPPER_CAP : upper);
+    st->yahtzee = game_state->yahtzee_achieved[player_id] == 'Y';
+    s->hint_base = banked;
+
+    // Bots evaluate their own turns
+    if (strategy.values && !s->bot) hint_request(&game_state->hints[player_id], st, &arena->hint_signal);
+}
+
+// Best distinct holds for the current dice. Only copies the worker's result
+// and does lookups: if the worker has not finished, say so instead of
+// searching here.
+static void session_hint_holds(Session *s) {
+    int player_id = s->player_id;
+    if (!strategy.values) {
+        session_printf(s, "Hints are unavailable (no strategy table on the server).\n");
+        return;
+    }
+
+    SolverTurn turn;
+    if (!hint_lookup(&game_state->hints[player_id], &s->hint_state, &turn)) {
+        session_printf(s, "Hint not ready yet, try again in a moment.\n");
+        return;
+    }
+
+    const int *dice = game_state->player_dice[player_id];
+    double value[32];
+    solver_turn_holds(&turn, dice, game_state->player_rerolls_left[player_id], value);
+
+    // Top three choices, one per keep: holding either of two equal dice is
+    // the same choice. Masks go from holding most to least, so ties favour
+    // keeping dice (and standing pat), like solver_turn_holds.
+    int keeps[3], shown = 0;
+    session_printf(s, "\nHint (expected final score with best play):\n");
+    while (shown < 3) {
+        int pick = -1;
+        for (int mask = 31; mask >= 0; mask--) {
+            int keep = reroll_keep_of_dice(dice, mask), dup = 0;
+            for (int j = 0; j < shown; j++) dup |= keeps[j] == keep;
+            if (!dup && (pick < 0 || value[mask] > value[pick] + 1e-4)) pick = mask;
+        }
+        if (pick < 0) break;
+        keeps[shown] = reroll_keep_of_dice(dice, pick);
+
+        char label[32] = "keep all dice";
+        if (pick != REROLL_HOLD_ALL) {
+            int len = snprintf(label, sizeof(label), "reroll dice");
+            for (int i = 0; i < 5; i++) {
+                if (!(pick & (1 << i))) len += snprintf(label + len, sizeof(label) - len, " %d", i + 1);
             }
         }
-    } else {
-        snprintf(buffer, sizeof(buffer),
-                 "Waiting for host to choose number of players...\n");
-        write(write_fd, buffer, strlen(buffer));
+        session_printf(s, "  %s %-22s -> %.1f\n", shown == 0 ? "*" : " ", label,
+                       s->hint_base + value[pick]);
+        shown++;
+    }
+}
 
-        while (1) {
-            pthread_mutex_lock(&game_state->game_mutex);
-            int target = game_state->target_players;
-            int connected = game_state->active_players;
-            pthread_mutex_unlock(&game_state->game_mutex);
+// Category values for the final roll: table lookups only, no worker needed
+static void session_hint_categories(Session *s) {
+    int player_id = s->player_id;
+    if (!strategy.values) {
+        session_printf(s, "Hints are unavailable (no strategy table on the server).\n");
+        return;
+    }
 
-            if (target > 0) {
-                snprintf(buffer, sizeof(buffer),
-                         "Host selected %d players. Currently connected: %d/%d\n",
-                         target, connected, target);
-                write(write_fd, buffer, strlen(buffer));
-                break;
+    SolverChoice opt[SCORING_NUM_CATEGORIES];
+    int n = solver_score_options(&strategy, &s->hint_state,
+                                 scoring_roll_index(game_state->player_dice[player_id]), opt);
+
+    for (int i = 1; i < n; i++) {
+        SolverChoice c = opt[i];
+        int j = i;
+        for (; j > 0 && opt[j - 1].value < c.value; j--) opt[j] = opt[j - 1];
+        opt[j] = c;
+    }
+
+    session_printf(s, "\nHint (expected final score with best play):\n");
+    for (int k = 0; k < n && k < 4; k++) {
+        session_printf(s, "  %s %2d. %-16s +%-3d -> %.1f\n",
+                       k == 0 ? "*" : " ", opt[k].category + 1,
+                       scoring_category_name(opt[k].category), opt[k].points,
+                       s->hint_base + opt[k].value);
+    }
+}
+
+// Yahtzee extra/Joker/forced rules (player lock held). When the Joker rule
+// auto-fills a category the turn ends and session_end_turn checks for game end.
+static void session_apply_yahtzee_rules_plocked(Session *s) {
+    int player_id = s->player_id;
+
+    game_state->skip_scoring[player_id] = 'N';
+    game_state->lower_section_only[player_id] = 'N';
+
+    int rolled_yahtzee = (game_state->player_scores[player_id][11][2] == 50);
+
+    if (rolled_yahtzee) {
+        if (game_state->amount_yahtzee[player_id] >= 1) {
+            session_printf(s, "\n\nCongratulations! You scored another Yahtzee!\n");
+
+            game_state->amount_yahtzee[player_id] += 1;
+
+            if (game_state->yahtzee_achieved[player_id] == 'Y') {
+                game_state->player_scores[player_id][14][0] += 100;
+                game_state->player_scores[player_id][14][1] = 1;
+                session_printf(s, "Yahtzee bonus awarded! (+100)\n");
+            }
+
+            if (game_state->player_scores[player_id][11][1] == 1 &&
+                game_state->yahtzee_achieved[player_id] == 'Y') {
+
+                int req = game_state->required_upper_section[player_id]; // 0..5
+                if (req >= 0 && req < 6 && game_state->player_scores[player_id][req][1] == 0) {
+
+                    game_state->player_scores[player_id][req][0] =
+                        game_state->player_scores[player_id][req][2];
+                    game_state->player_scores[player_id][req][1] = 1;
+
+                    session_printf(s,
+                             "Since you scored another Yahtzee and UPPER SECTION #%d is available,\n"
+                             "it has been automatically filled with %d points.\n",
+                             req + 1, game_state->player_scores[player_id][req][0]);
+
+                    game_state->skip_scoring[player_id] = 'Y';
+                    journal_score(player_id, req, 1, game_state->player_scores[player_id][req][0]);
+
+                    update_section_flags_plocked(player_id);
+                    maybe_award_upper_bonus_plocked(player_id);
+
+                } else if (req >= 0 && req < 6 &&
+                           game_state->player_scores[player_id][req][1] == 1 &&
+                           game_state->lower_section_filled[player_id] == 'N') {
+                    session_printf(s,
+                             "Since UPPER SECTION #%d is NOT available, you may use this Yahtzee\n"
+                             "to score any LOWER SECTION category.\n",
+                             req + 1);
+                    game_state->lower_section_only[player_id] = 'Y';
+                }
             }
-            sleep(1);
+        } else {
+            session_printf(s, "\n\nCongratulations! You scored a Yahtzee!\n");
+            game_state->amount_yahtzee[player_id] = 1;
         }
     }
 
-    snprintf(buffer, sizeof(buffer), "Waiting for game to start...\n");
-    write(write_fd, buffer, strlen(buffer));
+    update_section_flags_plocked(player_id);
+    maybe_award_upper_bonus_plocked(player_id);
+}
+
+// The open categories the dice can go in, then the category prompt
+static void session_offer_categories(Session *s) {
+    int player_id = s->player_id;
+    int first = (game_state->lower_section_only[player_id] == 'N') ? 0 : 6;
+    int open_cats[13], count = 0;
+    for (int i = first; i < 13; i++) {
+        if (game_state->player_scores[player_id][i][1] == 0) open_cats[count++] = i;
+    }
+
+    ProtoMsg m;
+    proto_begin(&m, MSG_OPTIONS);
+    proto_put_u8(&m, count);
+    for (int k = 0; k < count; k++) {
+        proto_put_u8(&m, open_cats[k]);
+        proto_put_i16(&m, game_state->player_scores[player_id][open_cats[k]][2]);
+    }
+    session_send(s, &m);
+
+    session_prompt_category(s);
+}
 
-    while (1) {
-        pthread_mutex_lock(&game_state->game_mutex);
-        int started = game_state->game_started;
-        pthread_mutex_unlock(&game_state->game_mutex);
-
-        if (started) break;
-        sleep(1);
-    }
-
-    // Exit if this player isn't a participant
-    pthread_mutex_lock(&game_state->game_mutex);
-    int am_participant = game_state->participants[player_id];
-    pthread_mutex_unlock(&game_state->game_mutex);
-    if (!am_participant) {
-        write(write_fd, "Server: You are not a participant in this match.\n", 51);
-        close(write_fd);
-        close(read_fd);
-        exit(0);
+// Returns 0 when the Joker rules already scored this turn
+static int session_begin_scoring(Session *s) {
+    int player_id = s->player_id;
+
+    journal_event(JNL_STAND, player_id, NULL, 0);
+    calculate_possible_scores(player_id);
+
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    session_apply_yahtzee_rules_plocked(s);
+    game_state->turn_phase[player_id] = TURN_SCORING;
+    publish_player_plocked(player_id);
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+
+    // Scoring selection
+    if (game_state->skip_scoring[player_id] == 'N') {
+        session_offer_categories(s);
+        return 1;
+    }
+    return 0;
+}
+
+// Show the player's scorecard; only this player's lock is needed
+static void session_send_scorecard(Session *s) {
+    int player_id = s->player_id;
+    ProtoMsg m;
+    proto_begin(&m, MSG_SCORECARD);
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+
+    int upper_total = 0;
+    for (int i = 0; i < 13; i++) {
+        proto_put_i16(&m, game_state->player_scores[player_id][i][0]);
+        proto_put_u8(&m, game_state->player_scores[player_id][i][1]);
+        if (i < 6) upper_total += game_state->player_scores[player_id][i][0];
+    }
+    proto_put_u8(&m, game_state->bonus_achieved[player_id] == 'Y');
+    proto_put_i16(&m, upper_total);
+    proto_put_i16(&m, game_state->player_scores[player_id][14][1] == 1
+                      ? game_state->player_scores[player_id][14][0] : -1);
+
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+    session_send(s, &m);
+}
+
+static void session_end_turn(Session *s) {
+    int player_id = s->player_id;
+
+    // If player just finished mark as done (maybe_end_game_nolock re-checks
+    // every participant under their own locks)
+    pthread_mutex_lock(&game_state->match_mutex);
+    maybe_end_game_nolock();
+    pthread_mutex_unlock(&game_state->match_mutex);
+
+    pthread_mutex_lock(&game_state->player_mutex[player_id]);
+    game_state->turn_phase[player_id] = TURN_IDLE;
+    pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+
+    session_send_scorecard(s);
+    session_printf(s, "Turn complete. Waiting for other players...\n");
+    session_account_turn(s);
+
+    s->in_turn = 0;
+    s->state = SESS_WAIT_TURN;
+    sem_post(&game_state->turn_done_sem[player_id]);
+}
+
+// Leave the lobby after the match
+static void session_finish(Session *s) {
+    int player_id = s->player_id;
+
+    pthread_mutex_lock(&game_state->match_mutex);
+    if (game_state->player_connected[player_id]) {
+        game_state->player_connected[player_id] = 0;
+        if (game_state->active_players > 0) game_state->active_players--;
+    }
+    game_state->child_pid[player_id] = -1;
+    pthread_mutex_unlock(&game_state->match_mutex);
+    notify_server();
+}
+
+// Leaderboard screen: the top entries come from the snapshot (no store
+// scan, no lock); only this player's own rank is a store query, O(log n)
+static void session_show_leaders(Session *s) {
+    if (!snap_arena || !score_store || s->bot) return;
+
+    SnapLeaders sl;
+    seqlock_read(&snap_arena->leaders.seq, &sl, &snap_arena->leaders, sizeof(sl));
+    if (sl.count == 0) return;
+
+    session_printf(s, "\n---------- LEADERBOARD (%u players) ----------\n", sl.players);
+    session_printf(s, "%3s  %-16s %5s %6s %7s %5s\n", "#", "Name", "Wins", "Games", "Avg", "High");
+    for (int i = 0; i < sl.count; i++) {
+        const SnapLeader *e = &sl.top[i];
+        session_printf(s, "%3d  %-16.16s %5u %6u %7.1f %5u\n", i + 1, e->name, e->wins, e->games,
+                       e->games ? (double)e->total_score / e->games : 0.0, e->high_score);
+    }
+
+    PlayerStats me;
+    uint32_t rank = store_rank(score_store, game_state->player_names[s->player_id], &me);
+    if (rank > 0) {
+        session_printf(s, "You: #%u with %u wins in %u games, avg %.1f, best %u\n",
+                       rank, me.wins, me.games, player_average(&me), me.high_score);
+    } else {
+        session_printf(s, "You: no games on record yet\n");
+    }
+}
+
+static void session_game_over(Session *s) {
+    int player_id = s->player_id;
+
+    // GAME OVER output
+    pthread_mutex_lock(&game_state->match_mutex);
+    int winner = game_state->winner_id;
+    int my_final = game_state->final_scores[player_id];
+    int finished = game_state->game_finished;
+    pthread_mutex_unlock(&game_state->match_mutex);
+
+    if (finished) {
+        ProtoMsg m;
+        proto_begin(&m, MSG_GAME_OVER);
+        proto_put_i16(&m, my_final);
+        proto_put_u8(&m, winner);
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        int count = 0;
+        for (int p = 0; p < MAX_PLAYERS; p++) count += game_state->participants[p] ? 1 : 0;
+        proto_put_u8(&m, count);
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            if (!game_state->participants[p]) continue;
+            proto_put_u8(&m, p);
+            proto_put_i16(&m, game_state->final_scores[p]);
+            proto_put_str(&m, game_state->player_names[p]);
+        }
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        session_send(s, &m);
+        session_show_leaders(s);
+    }
+
+    session_finish(s);
+
+    session_printf(s, "Disconnecting...\n");
+
+    if (!quiet) {
+        printf("[SYSTEM] Player %d (%s) disconnected\n",
+               player_id + 1, game_state->player_names[player_id]);
     }
+}
 
-    snprintf(buffer, sizeof(buffer), "\n*** GAME STARTING! ***\n\n");
-    write(write_fd, buffer, strlen(buffer));
+// The token that lets this player take the seat back (none for bots)
+static void session_send_seat(Session *s) {
+    int player_id = s->player_id;
+    pthread_mutex_lock(&game_state->match_mutex);
+    uint64_t token = game_state->seat_token[player_id];
+    pthread_mutex_unlock(&game_state->match_mutex);
+    if (token == 0) return;
+
+    ProtoMsg m;
+    proto_begin(&m, MSG_SEAT);
+    proto_put_u8(&m, game_state->lobby_id);
+    proto_put_u8(&m, player_id);
+    proto_put_bytes(&m, &token, sizeof(token));
+    session_send(s, &m);
+}
 
-    const char *categories[] = {
-        "Aces", "Twos", "Threes", "Fours", "Fives", "Sixes",
-        "Three of a Kind", "Four of a Kind", "Full House",
-        "Small Straight", "Large Straight", "Yahtzee", "Chance"
-    };
+static SessionWait session_run(Session *s) {
+    char line[256];
+    int player_id = s->player_id;
+    int r;
 
     while (1) {
-        sem_wait(&game_state->turn_sem[player_id]);
+        switch (s->state) {
+        case SESS_OPEN:
+            if (session_open(s) < 0) {
+                perror("open FIFOs failed");
+                return session_hangup(s);
+            }
+            break;
 
-        pthread_mutex_lock(&game_state->game_mutex);
-        int finished = game_state->game_finished;
-        int my_done  = game_state->player_done[player_id];
-        struct timespec deadline = game_state->turn_deadline[player_id];
-        pthread_mutex_unlock(&game_state->game_mutex);
-
-        if (finished || my_done) break;
-        if (!game_state->player_connected[player_id]) break;
-
-        snprintf(buffer, sizeof(buffer),
-                 "\n========================================\n"
-                 "[YOUR TURN, %s]\n"
-                 "========================================\n",
-                 game_state->player_names[player_id]);
-        write(write_fd, buffer, strlen(buffer));
-
-        pthread_mutex_lock(&game_state->game_mutex);
-        game_state->player_rerolls_left[player_id] = 2;
-        pthread_mutex_unlock(&game_state->game_mutex);
-
-        roll_dice(player_id);
-
-        snprintf(buffer, sizeof(buffer), "Your dice: [%d] [%d] [%d] [%d] [%d]\n",
-                 game_state->player_dice[player_id][0],
-                 game_state->player_dice[player_id][1],
-                 game_state->player_dice[player_id][2],
-                 game_state->player_dice[player_id][3],
-                 game_state->player_dice[player_id][4]);
-        write(write_fd, buffer, strlen(buffer));
-
-        // Reroll
-        while (game_state->player_rerolls_left[player_id] > 0) {
-            snprintf(buffer, sizeof(buffer), "\nRerolls left: %d. Reroll? (Y/N): ",
-                     game_state->player_rerolls_left[player_id]);
-            write(write_fd, buffer, strlen(buffer));
-
-            n = timed_read_line(read_fd, recv_buffer, sizeof(recv_buffer), &deadline);
-            if (n == -2) { forfeit_turn_timeout(player_id, write_fd); goto next_turn; }
-            if (n <= 0) child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
-
-            if (recv_buffer[0] == 'N' || recv_buffer[0] == 'n') break;
-
-            if (recv_buffer[0] == 'Y' || recv_buffer[0] == 'y') {
-                snprintf(buffer, sizeof(buffer), "Which dice? (e.g., 1 3 5): ");
-                write(write_fd, buffer, strlen(buffer));
-
-                n = timed_read_line(read_fd, recv_buffer, sizeof(recv_buffer), &deadline);
-                if (n == -2) { forfeit_turn_timeout(player_id, write_fd); goto next_turn; }
-                if (n <= 0) child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
-
-                int dice_to_reroll[5];
-                int count = 0;
-                char *token = strtok(recv_buffer, " \n");
-                while (token && count < 5) {
-                    int die = atoi(token);
-                    if (die >= 1 && die <= 5) dice_to_reroll[count++] = die;
-                    token = strtok(NULL, " \n");
+        case SESS_NAME: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
+
+            line[strcspn(line, "\n")] = '\0';
+            pthread_mutex_lock(&game_state->match_mutex);
+            strncpy(game_state->player_names[player_id], line, NAME_SIZE - 1);
+            publish_match_nolock();
+
+            char join_msg[128];
+            snprintf(join_msg, sizeof(join_msg), "Player %d identified as %s\n", player_id + 1, game_state->player_names[player_id]);
+            log_message(join_msg);
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            session_printf(s, "Welcome %s! You are Player %d\n",
+                           game_state->player_names[player_id], player_id + 1);
+            session_show_leaders(s);
+
+            pthread_mutex_lock(&game_state->match_mutex);
+            if (game_state->host_player_id < 0) game_state->host_player_id = player_id;
+            int host_id = game_state->host_player_id;
+            int target = game_state->target_players;
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            if (player_id == host_id) {
+                if (target > 0) {
+                    session_printf(s, "Waiting for game to start...\n");
+                    s->state = SESS_WAIT_START;
+                } else {
+                    session_prompt(s, PROMPT_PLAYERS, 3, MAX_PLAYERS);
+                    s->state = SESS_HOST_SETUP;
                 }
+            } else {
+                session_printf(s, "Waiting for host to choose number of players...\n");
+                s->state = SESS_WAIT_TARGET;
+            }
+            break;
+        }
+
+        case SESS_HOST_SETUP: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
 
-                if (count > 0) {
-                    reroll_dice(player_id, dice_to_reroll, count);
-                    pthread_mutex_lock(&game_state->game_mutex);
-                    game_state->player_rerolls_left[player_id]--;
-                    pthread_mutex_unlock(&game_state->game_mutex);
-
-                    snprintf(buffer, sizeof(buffer), "New dice: [%d] [%d] [%d] [%d] [%d]\n",
-                             game_state->player_dice[player_id][0],
-                             game_state->player_dice[player_id][1],
-                             game_state->player_dice[player_id][2],
-                             game_state->player_dice[player_id][3],
-                             game_state->player_dice[player_id][4]);
-                    write(write_fd, buffer, strlen(buffer));
+            int t = atoi(line);
+
+            if (t >= 3 && t <= MAX_PLAYERS) {
+                pthread_mutex_lock(&game_state->match_mutex);
+                game_state->target_players = t;
+                int connected = game_state->active_players;
+                lobby_changed_nolock();
+                pthread_mutex_unlock(&game_state->match_mutex);
+
+                session_printf(s,
+                               "✓ Lobby set to %d players. Currently connected: %d/%d\n",
+                               t, connected, t);
+                if (connected < t) {
+                    session_prompt(s, PROMPT_BOTS, 0, BOT_HARD);
+                    s->state = SESS_HOST_BOTS;
+                } else {
+                    session_printf(s, "Waiting for game to start...\n");
+                    s->state = SESS_WAIT_START;
                 }
+            } else {
+                session_printf(s, "Invalid number. Please enter a value between 3 and %d.\n",
+                               MAX_PLAYERS);
+                session_prompt(s, PROMPT_PLAYERS, 3, MAX_PLAYERS);
+            }
+            break;
+        }
+
+        case SESS_HOST_BOTS: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
+
+            int level = atoi(line);
+            if (level < 0 || level > BOT_HARD || line[0] < '0' || line[0] > '9') {
+                session_printf(s, "Invalid choice. Please enter a value between 0 and %d.\n", BOT_HARD);
+                session_prompt(s, PROMPT_BOTS, 0, BOT_HARD);
+                break;
+            }
+
+            // The server seats the bots (service_lobby) and starts the match
+            if (level > 0) {
+                pthread_mutex_lock(&game_state->match_mutex);
+                game_state->bot_fill = level;
+                lobby_changed_nolock();
+                pthread_mutex_unlock(&game_state->match_mutex);
+                session_printf(s, "Filling the empty seats with %s bots.\n", bot_level_name(level));
+            } else {
+                session_printf(s, "Waiting for remaining players to join...\n");
             }
+            session_printf(s, "Waiting for game to start...\n");
+            s->state = SESS_WAIT_START;
+            break;
         }
 
-        calculate_possible_scores(player_id);
+        case SESS_WAIT_TARGET: {
+            pthread_mutex_lock(&game_state->match_mutex);
+            int target = game_state->target_players;
+            int connected = game_state->active_players;
+            s->lobby_gen = game_state->lobby_gen;
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            if (target == 0) return SESSION_WAIT_LOBBY;
 
-        // Yahtzee extra/Joker/forced rules
-        pthread_mutex_lock(&game_state->game_mutex);
+            session_printf(s, "Host selected %d players. Currently connected: %d/%d\n",
+                           target, connected, target);
+            session_printf(s, "Waiting for game to start...\n");
+            s->state = SESS_WAIT_START;
+            break;
+        }
 
-        game_state->skip_scoring[player_id] = 'N';
-        game_state->lower_section_only[player_id] = 'N';
+        case SESS_WAIT_START: {
+            pthread_mutex_lock(&game_state->match_mutex);
+            int started = game_state->game_started;
+            int am_participant = game_state->participants[player_id];
+            s->lobby_gen = game_state->lobby_gen;
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            if (!started) return SESSION_WAIT_LOBBY;
+
+            // Exit if this player isn't a participant. The seat is freed
+            // by whoever ran the session: reap_children for a forked child,
+            // pool_worker for a pooled one
+            if (!am_participant) {
+                session_printf(s, "Server: You are not a participant in this match.\n");
+                s->left_out = 1;
+                s->state = SESS_DONE;
+                return SESSION_DONE;
+            }
 
-        int rolled_yahtzee = (game_state->player_scores[player_id][11][2] == 50);
+            session_printf(s, "\n*** GAME STARTING! ***\n\n");
+            session_send_seat(s);
+            s->state = SESS_WAIT_TURN;
+            break;
+        }
 
-        if (rolled_yahtzee) {
-            if (game_state->amount_yahtzee[player_id] >= 1) {
-                snprintf(buffer, sizeof(buffer),
-                         "\n\nCongratulations! You scored another Yahtzee!\n");
-                write(write_fd, buffer, strlen(buffer));
+        case SESS_REJOIN:
+            session_printf(s, "Welcome back %s! You are Player %d in lobby %d.\n",
+                           game_state->player_names[player_id], player_id + 1,
+                           game_state->lobby_id + 1);
+            session_send_scorecard(s);
+            session_send_seat(s);
+            session_printf(s, "Waiting for your turn...\n");
+            s->state = SESS_WAIT_TURN;
+            break;
 
-                game_state->amount_yahtzee[player_id] += 1;
+        case SESS_WAIT_TURN: {
+            if (!s->turn_granted) {
+                if (sem_trywait(&game_state->turn_sem[player_id]) != 0) return SESSION_WAIT_TURN;
+            }
+            s->turn_granted = 0;
 
-                if (game_state->yahtzee_achieved[player_id] == 'Y') {
-                    game_state->player_scores[player_id][14][0] += 100;
-                    game_state->player_scores[player_id][14][1] = 1;
-                    snprintf(buffer, sizeof(buffer),
-                             "Yahtzee bonus awarded! (+100)\n");
-                    write(write_fd, buffer, strlen(buffer));
-                }
+            pthread_mutex_lock(&game_state->match_mutex);
+            int finished = game_state->game_finished;
+            int my_done  = game_state->player_done[player_id];
+            s->deadline  = game_state->turn_deadline[player_id];
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            if (finished || my_done || !game_state->player_connected[player_id]) {
+                session_game_over(s);
+                s->state = SESS_DONE;
+                return SESSION_DONE;
+            }
+
+            s->in_turn = 1;
+            s->turn_io_mark = s->io_calls;
+
+            session_printf(s,
+                           "\n========================================\n"
+                           "[YOUR TURN, %s]\n"
+                           "========================================\n",
+                           game_state->player_names[player_id]);
+
+            pthread_mutex_lock(&game_state->player_mutex[player_id]);
+            int phase = game_state->turn_phase[player_id];
+            if (phase == TURN_IDLE) game_state->player_rerolls_left[player_id] = 2;
+            int rerolls = game_state->player_rerolls_left[player_id];
+            pthread_mutex_unlock(&game_state->player_mutex[player_id]);
+
+            session_post_hint_state(s);
+            if (phase == TURN_IDLE) {
+                roll_dice(player_id);
+                session_show_dice(s, DICE_ROLLED);
+                session_prompt_reroll(s);
+                break;
+            }
+
+            // Back after a dropped connection: same dice, same stage
+            session_printf(s, "Picking up your turn where you left it.\n");
+            session_show_dice(s, DICE_ROLLED);
+            if (phase == TURN_SCORING) {
+                session_offer_categories(s);
+            } else if (rerolls > 0) {
+                session_prompt_reroll(s);
+            } else if (!session_begin_scoring(s)) {
+                session_end_turn(s);
+            }
+            break;
+        }
+
+        case SESS_REROLL: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
+            if (r == 2) break;
+
+            if (is_hint_request(line)) {
+                session_hint_holds(s);
+                session_prompt_reroll(s);
+            } else if (line[0] == 'N' || line[0] == 'n') {
+                if (!session_begin_scoring(s)) session_end_turn(s);
+            } else if (line[0] == 'Y' || line[0] == 'y') {
+                session_prompt(s, PROMPT_WHICH_DICE, 1, 5);
+                s->state = SESS_WHICH_DICE;
+            } else {
+                session_prompt_reroll(s);
+            }
+            break;
+        }
+
+        case SESS_WHICH_DICE: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
+            if (r == 2) break;
+
+            if (is_hint_request(line)) {
+                session_hint_holds(s);
+                session_prompt(s, PROMPT_WHICH_DICE, 1, 5);
+                break;
+            }
+
+            int dice_to_reroll[5];
+            int count = 0;
+            char *save = NULL;
+            char *token = strtok_r(line, " \n", &save);
+            while (token && count < 5) {
+                int die = atoi(token);
+                if (die >= 1 && die <= 5) dice_to_reroll[count++] = die;
+                token = strtok_r(NULL, " \n", &save);
+            }
+
+            if (count > 0) {
+                reroll_dice(player_id, dice_to_reroll, count);
+
+                session_show_dice(s, DICE_REROLLED);
+            }
+
+            if (game_state->player_rerolls_left[player_id] > 0) {
+                session_prompt_reroll(s);
+            } else if (!session_begin_scoring(s)) {
+                session_end_turn(s);
+            }
+            break;
+        }
 
-                if (game_state->player_scores[player_id][11][1] == 1 &&
-                    game_state->yahtzee_achieved[player_id] == 'Y') {
-
-                    int req = game_state->required_upper_section[player_id]; // 0..5
-                    if (req >= 0 && req < 6 && game_state->player_scores[player_id][req][1] == 0) {
-
-                        game_state->player_scores[player_id][req][0] =
-                            game_state->player_scores[player_id][req][2];
-                        game_state->player_scores[player_id][req][1] = 1;
-
-                        snprintf(buffer, sizeof(buffer),
-                                 "Since you scored another Yahtzee and UPPER SECTION #%d is available,\n"
-                                 "it has been automatically filled with %d points.\n",
-                                 req + 1, game_state->player_scores[player_id][req][0]);
-                        write(write_fd, buffer, strlen(buffer));
-
-                        game_state->skip_scoring[player_id] = 'Y';
-
-                        update_section_flags_nolock(player_id);
-                        maybe_award_upper_bonus_nolock(player_id);
-                        maybe_end_game_nolock();
-
-                    } else if (req >= 0 && req < 6 &&
-                               game_state->player_scores[player_id][req][1] == 1 &&
-                               game_state->lower_section_filled[player_id] == 'N') {
-                        snprintf(buffer, sizeof(buffer),
-                                 "Since UPPER SECTION #%d is NOT available, you may use this Yahtzee\n"
-                                 "to score any LOWER SECTION category.\n",
-                                 req + 1);
-                        write(write_fd, buffer, strlen(buffer));
-                        game_state->lower_section_only[player_id] = 'Y';
-                    }
+        case SESS_CATEGORY: {
+            r = session_input(s, line, sizeof(line));
+            if (r == 0) return SESSION_WAIT_INPUT;
+            if (r < 0) return session_hangup(s);
+            if (r == 2) break;
+
+            int choice = atoi(line);
+
+            if (is_hint_request(line)) {
+                session_hint_categories(s);
+                session_prompt_category(s);
+            } else if (game_state->lower_section_only[player_id] == 'Y' && choice < 7) {
+                session_prompt_category(s);
+            } else if (choice >= 1 && choice <= 13 &&
+                       game_state->player_scores[player_id][choice - 1][1] == 0) {
+                if (apply_score(player_id, choice - 1)) {
+                    session_printf(s, "Scored %d points in %s!\n",
+                                   game_state->player_scores[player_id][choice - 1][0],
+                                   scoring_category_name(choice - 1));
                 }
+                session_end_turn(s);
             } else {
-                snprintf(buffer, sizeof(buffer),
-                         "\n\nCongratulations! You scored a Yahtzee!\n");
-                write(write_fd, buffer, strlen(buffer));
-                game_state->amount_yahtzee[player_id] = 1;
+                session_printf(s, "Invalid choice! Try again.\n");
+                session_prompt_category(s);
+            }
+            break;
+        }
+
+        case SESS_DONE:
+            return SESSION_DONE;
+        }
+    }
+}
+
+// Run the session until it has to wait, then send the screen it built
+static SessionWait session_step(Session *s) {
+    // A client that hung up is gone whatever the session was waiting for
+    if (s->eof && s->inlen == 0 && s->state != SESS_DONE) return session_hangup(s);
+
+    SessionWait w = session_run(s);
+    // Input left over from a client that hung up would only be read at its
+    // next prompt; give the seat up now so the match holds it
+    if (s->eof && (w == SESSION_WAIT_LOBBY || w == SESSION_WAIT_TURN)) w = session_hangup(s);
+    session_flush(s);
+    return w;
+}
+
+static void session_close_fds(Session *s) {
+    if (s->ring) {
+        ring_close(&s->ring->to_client);
+        ring_close(&s->ring->to_server);
+        ring_segment_unmap(s->ring);
+        s->ring = NULL;
+    }
+    if (s->write_fd >= 0) close(s->write_fd);
+    if (s->read_fd  >= 0) close(s->read_fd);
+    s->write_fd = -1;
+    s->read_fd  = -1;
+}
+
+
+// A client asking to join: where to reach it, the ring and seat token it
+// offers, and its FIFO ends if the waiting room already opened them
+typedef struct {
+    char fifo[256];
+    char ring[RING_NAME_SIZE];
+    uint64_t token;
+    int write_fd;                   // -1 = not opened yet
+    int read_fd;
+} JoinRequest;
+
+// Fork mode: one child process per player
+
+static void run_session_blocking(Session *s) {
+    while (1) {
+        SessionWait w = session_step(s);
+
+        if (w == SESSION_DONE) return;
+
+        if (w == SESSION_WAIT_INPUT) {
+            int timeout = -1;
+            if (s->in_turn) {
+                timeout = ms_until_deadline(&s->deadline);
+                if (timeout == 0) continue;     // step handles the expiry
             }
+
+            // SIGUSR1 from the scheduler interrupts the wait; step re-checks the turn
+            if (s->ring) {
+                unsigned long before = ring_syscalls();
+                int ready = ring_wait(&s->ring->to_server, timeout);
+                s->io_calls += ring_syscalls() - before;
+                if (ready > 0) session_fill_input(s);
+                continue;
+            }
+
+            struct pollfd pfd;
+            pfd.fd = s->read_fd;
+            pfd.events = POLLIN;
+
+            s->io_calls++;
+            if (poll(&pfd, 1, timeout) > 0) session_fill_input(s);
+        } else if (w == SESSION_WAIT_LOBBY) {
+            pthread_mutex_lock(&game_state->match_mutex);
+            while (game_state->lobby_gen == s->lobby_gen) {
+                pthread_cond_wait(&game_state->lobby_cond, &game_state->match_mutex);
+            }
+            pthread_mutex_unlock(&game_state->match_mutex);
+        } else if (w == SESSION_WAIT_TURN) {
+            while (sem_wait(&game_state->turn_sem[s->player_id]) == -1 && errno == EINTR) {
+            }
+            s->turn_granted = 1;
+        }
+    }
+}
+
+void handle_client(int player_id, JoinRequest *req, int rejoin) {
+    // allow scheduler to force-end this player's turn on quantum expiry
+    g_child_state = game_state;
+    g_child_player_id = player_id;
+    {
+        struct sigaction sa2;
+        memset(&sa2, 0, sizeof(sa2));
+        sa2.sa_handler = sigusr1_handler;
+        sigemptyset(&sa2.sa_mask);
+        sa2.sa_flags = 0;
+        sigaction(SIGUSR1, &sa2, NULL);
+    }
+
+    Session *s = session_create(game_state, player_id, req->fifo, req->ring);
+    if (s) {
+        s->rejoin = rejoin;
+        s->write_fd = req->write_fd;
+        s->read_fd = req->read_fd;
+    }
+    if (!s || session_open(s) < 0) {
+        perror("open FIFOs failed");
+        exit(1);
+    }
+
+    // watchdog to detect client disconnect even while blocked
+    WatchArgs *wa = (WatchArgs*)malloc(sizeof(*wa));
+    if (!wa) {
+        perror("malloc watchdog");
+        child_mark_disconnect_and_exit(player_id, s->write_fd, s->read_fd);
+    }
+    wa->gs        = game_state;
+    wa->player_id = player_id;
+    wa->read_fd   = s->read_fd;
+    wa->write_fd  = s->write_fd;
+    pthread_t wd_tid;
+    pthread_create(&wd_tid, NULL, disconnect_watchdog, wa);
+    pthread_detach(wd_tid);
+
+    run_session_blocking(s);
+
+    if (s->disconnected) child_mark_disconnect_and_exit(player_id, s->write_fd, s->read_fd);
+
+    session_close_fds(s);
+    exit(0);
+}
+
+
+// Bots: server-run players
+//
+// A bot is an ordinary session without a client. It waits on the same
+// turn semaphore, walks the same prompts and scoring rules, and its
+// answers come from bot.h instead of a FIFO. The threads live in the
+// server process, so they outlast the host's session in fork mode.
+
+static void *bot_thread(void *arg) {
+    Session *s = (Session*)arg;
+    game_state = s->gs;
+
+    run_session_blocking(s);
+
+    const Bot *b = s->bot;
+    printf("[BOT] Lobby %d: Player %d (%s) made %lu decisions, slowest %ld us, "
+           "%lu below its level, %lu over the %ld us budget\n",
+           game_state->lobby_id + 1, s->player_id + 1, bot_level_name(b->level), b->decisions,
+           b->max_ns / 1000, b->downgrades, b->overruns, b->budget_ns / 1000);
+
+    free(s->bot);
+    free(s);
+    return NULL;
+}
+
+// Put a `level` bot in seat p, its session starting in `state`
+static int spawn_bot_nolock(int p, int level, SessionState state) {
+    Session *s = session_create(game_state, p, "", NULL);
+    Bot *b = (Bot*)malloc(sizeof(Bot));
+    if (!s || !b) {
+        free(s);
+        free(b);
+        perror("bot allocation failed");
+        return -1;
+    }
+    bot_init(b, (BotLevel)level, bot_budget_ns);
+    s->bot = b;
+    s->state = state;
+
+    game_state->player_connected[p] = 1;
+    game_state->player_bot[p] = level;
+    game_state->active_players++;
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, bot_thread, s) != 0) {
+        game_state->player_connected[p] = 0;
+        game_state->player_bot[p] = 0;
+        game_state->active_players--;
+        free(b);
+        free(s);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+// Seat `level` bots in the lobby's empty seats until it reaches its target
+static void seat_bots_nolock(int level) {
+    for (int p = 0; p < MAX_PLAYERS && game_state->active_players < game_state->target_players; p++) {
+        if (game_state->player_connected[p]) continue;
+
+        snprintf(game_state->player_names[p], NAME_SIZE, "Bot%d-%s", p + 1, bot_level_name(level));
+        if (spawn_bot_nolock(p, level, SESS_WAIT_START) < 0) break;
+
+        printf("[BOT] Lobby %d: Player %d is a %s bot\n", game_state->lobby_id + 1, p + 1,
+               bot_level_name(level));
+    }
+    publish_match_nolock();
+}
+
+
+// Pool mode: sessions are driven by a reactor thread and a worker pool
+//
+// The reactor owns the epoll set (client read FIFOs, a wake eventfd and a
+// reschedule eventfd). Ready sessions go on a run queue; a worker steps a
+// session until it has to wait again and re-arms its FIFO. A session is
+// never stepped by two workers at once: events that arrive while it runs
+// set `rerun` and the same worker steps it again.
+
+#define POOL_DEFAULT_WORKERS 4
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  ready_cond;
+    Session *ready_head;
+    Session *ready_tail;
+
+    Session **slots;
+    int nslots;
+    uint32_t next_serial;
+
+    int epoll_fd;
+    int wake_fd;            // lobby or turn state changed somewhere
+    int resched_fd;         // a session armed an earlier deadline
+    struct timespec next_deadline;
+    int workers;
+} SessionPool;
+
+static SessionPool pool;
+
+static uint64_t pool_key(const Session *s) {
+    return ((uint64_t)s->serial << 32) | (uint32_t)s->slot;
+}
+
+static void pool_enqueue_locked(Session *s) {
+    if (s->running) {
+        s->rerun = 1;
+        return;
+    }
+    if (s->queued) return;
+
+    s->queued = 1;
+    s->next_ready = NULL;
+    if (pool.ready_tail) pool.ready_tail->next_ready = s;
+    else pool.ready_head = s;
+    pool.ready_tail = s;
+    pthread_cond_signal(&pool.ready_cond);
+}
+
+static void pool_kick(int fd) {
+    uint64_t one = 1;
+    ssize_t r = write(fd, &one, sizeof(one));
+    (void)r;
+}
+
+static void pool_drain(int fd) {
+    uint64_t cnt;
+    while (read(fd, &cnt, sizeof(cnt)) > 0) {}
+}
+
+// Wake sessions waiting on a lobby or a turn (no-op in fork mode)
+static void wake_sessions(void) {
+    if (pool_mode) pool_kick(pool.wake_fd);
+}
+
+static int pool_add_session(GameState *gs, int player_id, JoinRequest *req, int rejoin) {
+    Session *s = session_create(gs, player_id, req->fifo, req->ring);
+    if (!s) return -1;
+    s->rejoin = rejoin;
+    s->write_fd = req->write_fd;
+    s->read_fd = req->read_fd;
+
+    pthread_mutex_lock(&pool.mutex);
+    int slot = -1;
+    for (int i = 0; i < pool.nslots; i++) {
+        if (!pool.slots[i]) { slot = i; break; }
+    }
+    if (slot < 0) {
+        int n = pool.nslots ? pool.nslots * 2 : 64;
+        Session **grown = (Session**)realloc(pool.slots, (size_t)n * sizeof(Session*));
+        if (!grown) {
+            pthread_mutex_unlock(&pool.mutex);
+            free(s);
+            return -1;
+        }
+        for (int i = pool.nslots; i < n; i++) grown[i] = NULL;
+        slot = pool.nslots;
+        pool.slots = grown;
+        pool.nslots = n;
+    }
+    s->slot = slot;
+    s->serial = ++pool.next_serial;
+    pool.slots[slot] = s;
+    pool_enqueue_locked(s);
+    pthread_mutex_unlock(&pool.mutex);
+    return 0;
+}
+
+static void pool_arm(Session *s) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    // Always armed so hangups are seen in every state; stop asking for input
+    // once the buffer is full
+    ev.events = EPOLLONESHOT | ((s->inlen < sizeof(s->inbuf)) ? EPOLLIN : 0);
+    ev.data.u64 = pool_key(s);
+
+    int op = s->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(pool.epoll_fd, op, s->read_fd, &ev) == 0) s->registered = 1;
+}
+
+static void* pool_worker(void* arg) {
+    (void)arg;
+
+    while (1) {
+        pthread_mutex_lock(&pool.mutex);
+        while (!pool.ready_head) pthread_cond_wait(&pool.ready_cond, &pool.mutex);
+
+        Session *s = pool.ready_head;
+        pool.ready_head = s->next_ready;
+        if (!pool.ready_head) pool.ready_tail = NULL;
+        s->queued = 0;
+        s->running = 1;
+        s->rerun = 0;
+        pthread_mutex_unlock(&pool.mutex);
+
+        game_state = s->gs;
+
+        SessionWait w;
+        int sooner = 0;
+        while (1) {
+            if (s->read_fd >= 0) {
+                while (session_fill_input(s) > 0) {}
+            }
+            w = session_step(s);
+            if (w == SESSION_DONE) break;
+
+            // A FIFO at EOF reports EPOLLHUP forever: never arm it again
+            if (s->read_fd >= 0 && !s->eof) {
+                int flags = fcntl(s->read_fd, F_GETFL);
+                if (!(flags & O_NONBLOCK)) fcntl(s->read_fd, F_SETFL, flags | O_NONBLOCK);
+                pool_arm(s);
+            }
+
+            pthread_mutex_lock(&pool.mutex);
+            if (s->rerun) {
+                s->rerun = 0;
+                pthread_mutex_unlock(&pool.mutex);
+                continue;
+            }
+            s->running = 0;
+            s->wait = w;
+
+            // The reactor sleeps until the earliest turn deadline; tell it about a sooner one
+            sooner = (w == SESSION_WAIT_INPUT && s->in_turn) &&
+                     (pool.next_deadline.tv_sec == 0 ||
+                      timespec_cmp(&s->deadline, &pool.next_deadline) < 0);
+            pthread_mutex_unlock(&pool.mutex);
+            break;
+        }
+
+        if (w == SESSION_DONE) {
+            // No child to reap: free the seat the way reap_children would
+            if (s->disconnected || s->left_out) release_disconnected_player(s->player_id);
+            session_close_fds(s);
+
+            // Still marked running, so the reactor cannot queue it again
+            pthread_mutex_lock(&pool.mutex);
+            pool.slots[s->slot] = NULL;
+            pthread_mutex_unlock(&pool.mutex);
+            free(s);
+            continue;
+        }
+
+        if (sooner) pool_kick(pool.resched_fd);
+    }
+    return NULL;
+}
+
+static void* pool_reactor(void* arg) {
+    (void)arg;
+
+    while (1) {
+        // Earliest deadline among sessions waiting for input during a turn
+        pthread_mutex_lock(&pool.mutex);
+        pool.next_deadline.tv_sec = 0;
+        pool.next_deadline.tv_nsec = 0;
+        for (int i = 0; i < pool.nslots; i++) {
+            Session *s = pool.slots[i];
+            if (!s || s->running || s->queued) continue;
+            if (s->wait != SESSION_WAIT_INPUT || !s->in_turn) continue;
+            if (pool.next_deadline.tv_sec == 0 ||
+                timespec_cmp(&s->deadline, &pool.next_deadline) < 0) {
+                pool.next_deadline = s->deadline;
+            }
+        }
+        int timeout = (pool.next_deadline.tv_sec == 0) ? -1 : ms_until_deadline(&pool.next_deadline) + 1;
+        pthread_mutex_unlock(&pool.mutex);
+
+        struct epoll_event events[64];
+        int n = epoll_wait(pool.epoll_fd, events, 64, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait (pool)");
+            continue;
+        }
+
+        int wake_all = 0;
+        pthread_mutex_lock(&pool.mutex);
+        for (int e = 0; e < n; e++) {
+            uint64_t key = events[e].data.u64;
+            if (key == (uint64_t)pool.wake_fd) {
+                pool_drain(pool.wake_fd);
+                wake_all = 1;
+                continue;
+            }
+            if (key == (uint64_t)pool.resched_fd) {
+                pool_drain(pool.resched_fd);
+                continue;
+            }
+
+            int slot = (int)(key & 0xffffffffu);
+            uint32_t serial = (uint32_t)(key >> 32);
+            if (slot < pool.nslots && pool.slots[slot] && pool.slots[slot]->serial == serial) {
+                pool_enqueue_locked(pool.slots[slot]);
+            }
+        }
+
+        for (int i = 0; i < pool.nslots; i++) {
+            Session *s = pool.slots[i];
+            if (!s || s->running || s->queued) continue;
+
+            int in_turn_input = (s->wait == SESSION_WAIT_INPUT && s->in_turn);
+            if (wake_all && (s->wait == SESSION_WAIT_LOBBY ||
+                             s->wait == SESSION_WAIT_TURN || in_turn_input)) {
+                pool_enqueue_locked(s);
+            } else if (in_turn_input && ms_until_deadline(&s->deadline) == 0) {
+                pool_enqueue_locked(s);
+            }
+        }
+        pthread_mutex_unlock(&pool.mutex);
+    }
+    return NULL;
+}
+
+static int pool_start(int workers) {
+    memset(&pool, 0, sizeof(pool));
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.ready_cond, NULL);
+    pool.workers = workers;
+
+    pool.epoll_fd   = epoll_create1(EPOLL_CLOEXEC);
+    pool.wake_fd    = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pool.resched_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pool.epoll_fd < 0 || pool.wake_fd < 0 || pool.resched_fd < 0) {
+        perror("pool setup failed");
+        return -1;
+    }
+
+    // Session keys always carry a non-zero serial in the upper half, so the
+    // bare fd numbers cannot collide with them
+    int ctl_fds[2] = {pool.wake_fd, pool.resched_fd};
+    for (int i = 0; i < 2; i++) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint64_t)ctl_fds[i];
+        if (epoll_ctl(pool.epoll_fd, EPOLL_CTL_ADD, ctl_fds[i], &ev) < 0) {
+            perror("epoll_ctl (pool)");
+            return -1;
+        }
+    }
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, pool_reactor, NULL) != 0) return -1;
+    pthread_detach(tid);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&tid, NULL, pool_worker, NULL) != 0) return -1;
+        pthread_detach(tid);
+    }
+
+    pool_mode = 1;
+    printf("✓ Session pool started (1 reactor + %d workers)\n", workers);
+    return 0;
+}
+
+// RR Scheduler
+
+void* scheduler_thread(void* arg) {
+    game_state = (GameState*)arg;
+    int lobby = game_state->lobby_id + 1;
+    printf("[SCHEDULER %d] RR Scheduler started (quantum=%ds)\n", lobby, QUANTUM_SECONDS);
+
+    // A restored match carries on from the turn it was saved at
+    int turn_index = game_state->current_turn;
+    checkpoint_match(turn_index);
+
+    while (1) {
+        pthread_mutex_lock(&game_state->match_mutex);
+
+        if (game_state->game_finished) {
+            pthread_mutex_unlock(&game_state->match_mutex);
+            break;
+        }
+
+        // Find next schedulable player
+        int start = turn_index;
+        int found = 0;
+        struct timespec now, held = {0, 0};     // earliest end of a seat being held
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        while (1) {
+            int is_participant = game_state->participants[turn_index];
+            int is_connected   = game_state->player_connected[turn_index];
+            int is_done        = game_state->player_done[turn_index];
+
+            if (is_participant && !is_connected && !is_done) {
+                // A held seat is skipped until its player is back or the
+                // hold runs out; otherwise a participant who left forfeits
+                const struct timespec *until = &game_state->reserve_until[turn_index];
+                if (until->tv_sec != 0 && timespec_cmp(until, &now) > 0) {
+                    if (held.tv_sec == 0 || timespec_cmp(until, &held) < 0) held = *until;
+                } else {
+                    game_state->reserve_until[turn_index].tv_sec = 0;
+                    forfeit_remaining_on_disconnect_nolock(turn_index);
+                    is_done = game_state->player_done[turn_index];
+                }
+            }
+
+            if (is_participant && is_connected && !is_done) {
+                found = 1;
+                break;
+            }
+
+            turn_index = (turn_index + 1) % MAX_PLAYERS;
+            if (turn_index == start) break;
+        }
+
+        if (!found) {
+            maybe_end_game_nolock();
+            if (!game_state->game_finished) {
+                if (held.tv_sec != 0) {
+                    pthread_cond_timedwait(&game_state->lobby_cond, &game_state->match_mutex, &held);
+                } else {
+                    pthread_cond_wait(&game_state->lobby_cond, &game_state->match_mutex);
+                }
+            }
+            pthread_mutex_unlock(&game_state->match_mutex);
+            continue;
+        }
+
+        game_state->current_turn = turn_index;
+        game_state->turn_active[turn_index] = 1;
+        publish_match_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        printf("[SCHEDULER %d] Turn -> Player %d (%ds quantum)\n", lobby,
+               turn_index + 1, QUANTUM_SECONDS);
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->turn_deadline[turn_index] = now;
+        game_state->turn_deadline[turn_index].tv_sec += QUANTUM_SECONDS;
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+
+        // Avoid late posts from previous turn instantly completing next turn
+        while (sem_trywait(&game_state->turn_done_sem[turn_index]) == 0) {
+        }
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->force_end_turn[turn_index] = 0;
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        sem_post(&game_state->turn_sem[turn_index]);
+        wake_sessions();
+
+        int r = wait_turn_done_or_disconnect(turn_index, QUANTUM_SECONDS);
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->turn_active[turn_index] = 0;
+        publish_match_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        if (r == -1) {
+            printf("[SCHEDULER %d] Player %d quantum expired\n", lobby, turn_index + 1);
+
+            pthread_mutex_lock(&game_state->match_mutex);
+            pid_t cpid = game_state->child_pid[turn_index];
+            game_state->force_end_turn[turn_index] = 1;
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            if (cpid > 0) {
+                kill(cpid, SIGUSR1);
+            }
+            wake_sessions();
+        } else if (r == 1) {
+            // A held seat keeps its half-played turn for when the player is
+            // back; otherwise forfeit now to prevent ghost turns
+            pthread_mutex_lock(&game_state->match_mutex);
+            int held = game_state->reserve_until[turn_index].tv_sec != 0;
+            if (!held && game_state->participants[turn_index] && !game_state->player_done[turn_index]) {
+                forfeit_remaining_on_disconnect_nolock(turn_index);
+            }
+            pthread_mutex_unlock(&game_state->match_mutex);
+
+            printf("[SCHEDULER %d] Player %d disconnected during turn%s\n", lobby, turn_index + 1,
+                   held ? ", seat held" : "");
+        } else {
+            printf("[SCHEDULER %d] Player %d completed their turn. (%d I/O syscalls)\n", lobby,
+                   turn_index + 1, game_state->turn_syscalls[turn_index]);
+        }
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        maybe_end_game_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        turn_index = (turn_index + 1) % MAX_PLAYERS;
+        checkpoint_match(turn_index);
+    }
+    checkpoint_match(0);
+
+    pthread_mutex_lock(&game_state->match_mutex);
+    unsigned long io_total = game_state->io_syscalls_total;
+    int io_turns = game_state->io_turns;
+    pthread_mutex_unlock(&game_state->match_mutex);
+    if (io_turns > 0) {
+        printf("[SCHEDULER %d] Session I/O: %.1f syscalls per turn over %d turns\n",
+               lobby, (double)io_total / io_turns, io_turns);
+    }
+
+    printf("[SCHEDULER %d] Scheduler ending\n", lobby);
+    notify_server();
+    return NULL;
+}
+
+// Lobby Reset
+static void reset_lobby_state_nolock(void) {
+    game_state->current_turn   = 0;
+    game_state->active_players = 0;
+    game_state->target_players = 0;
+    game_state->bot_fill       = 0;
+    game_state->host_player_id = -1;
+    game_state->game_started   = 0;
+    game_state->game_round     = 1;
+    game_state->game_finished  = 0;
+    game_state->winner_id      = -1;
+    game_state->participants_count = 0;
+    game_state->io_syscalls_total = 0;
+    game_state->io_turns = 0;
+
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        game_state->participants[p] = 0;
+        game_state->player_done[p] = 0;
+        game_state->final_scores[p] = 0;
+        game_state->player_connected[p] = 0;
+        game_state->player_bot[p] = 0;
+        game_state->child_pid[p] = -1;
+        game_state->force_end_turn[p] = 0;
+        game_state->turn_syscalls[p] = 0;
+        game_state->seat_token[p] = 0;
+        game_state->reserve_until[p].tv_sec = 0;
+
+        // wipe match scorecard
+        pthread_mutex_lock(&game_state->player_mutex[p]);
+        game_state->turn_phase[p] = TURN_IDLE;
+        for (int i = 0; i < 15; i++)
+            for (int k = 0; k < 3; k++)
+                game_state->player_scores[p][i][k] = 0;
+
+        // wipe per-match flags
+        game_state->yahtzee_achieved[p] = 'N';
+        game_state->amount_yahtzee[p] = 0;
+        game_state->required_upper_section[p] = -1;
+        game_state->lower_section_only[p] = 'N';
+        game_state->skip_scoring[p] = 'N';
+        game_state->bonus_achieved[p] = 'N';
+        game_state->upper_section_filled[p] = 'N';
+        game_state->lower_section_filled[p] = 'N';
+        publish_player_plocked(p);
+        pthread_mutex_unlock(&game_state->player_mutex[p]);
+
+        memset(game_state->player_names[p], 0, NAME_SIZE);
+
+        while (sem_trywait(&game_state->turn_sem[p]) == 0) {}
+        while (sem_trywait(&game_state->turn_done_sem[p]) == 0) {}
+    }
+    publish_match_nolock();
+}
+
+// Parent-side bookkeeping for each lobby's scheduler
+typedef struct {
+    pthread_t scheduler_tid;
+    int scheduler_created;
+    int reset_pending;
+} LobbyControl;
+
+// Pick the lobby a new connection should join. A lobby that is already
+// filling up wins over an idle one so players end up grouped together.
+static int find_open_lobby(const LobbyControl *ctl) {
+    int idle = -1;
+
+    for (int l = 0; l < arena->num_lobbies; l++) {
+        if (ctl[l].scheduler_created || ctl[l].reset_pending) continue;
+
+        GameState *gs = &arena->lobbies[l];
+        pthread_mutex_lock(&gs->match_mutex);
+        int limit = (gs->target_players > 0) ? gs->target_players : MAX_PLAYERS;
+        int open = !gs->game_started && gs->active_players < limit;
+        int filling = gs->active_players > 0;
+        pthread_mutex_unlock(&gs->match_mutex);
+
+        if (!open) continue;
+        if (filling) return l;
+        if (idle < 0) idle = l;
+    }
+    return idle;
+}
+
+// Take back the held seat whose token the client presented. Returns the
+// lobby (game_state points at it) and the seat, or -1.
+static int claim_held_seat(uint64_t token, int *player_id) {
+    for (int l = 0; l < arena->num_lobbies; l++) {
+        game_state = &arena->lobbies[l];
+        pthread_mutex_lock(&game_state->match_mutex);
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            if (game_state->seat_token[p] != token || !game_state->participants[p] ||
+                game_state->player_connected[p] || game_state->player_done[p] ||
+                game_state->reserve_until[p].tv_sec == 0) continue;
+
+            game_state->reserve_until[p].tv_sec = 0;
+            game_state->player_connected[p] = 1;
+            game_state->active_players++;
+            // A grant the old session never took must not start a turn now
+            while (sem_trywait(&game_state->turn_sem[p]) == 0) {}
+            lobby_changed_nolock();
+            pthread_mutex_unlock(&game_state->match_mutex);
+            *player_id = p;
+            return l;
+        }
+        pthread_mutex_unlock(&game_state->match_mutex);
+    }
+    return -1;
+}
+
+// Turn a client away, on the FIFO ends the waiting room holds if any
+static void reject_request(JoinRequest *req, const char *msg) {
+    if (req->write_fd < 0) {
+        reject_client(req->fifo, msg);
+        return;
+    }
+    ProtoMsg m;
+    proto_begin(&m, MSG_REJECT);
+    proto_put_str(&m, msg);
+    size_t len = proto_end(&m);
+    if (len) write(req->write_fd, m.data, len);
+    close(req->write_fd);
+    close(req->read_fd);
+    req->write_fd = req->read_fd = -1;
+}
+
+// Waiting room
+//
+// When no lobby can take a new client, its request joins a FIFO queue in
+// the parent instead of being turned away. The parent opens the client's
+// FIFOs straight away, so the client sits in its handshake read while the
+// queue sends it MSG_QUEUED with its place in line whenever that changes.
+// A client that gives up is noticed through a hangup on its FIFO (the
+// read end is in the main epoll set). Whenever a lobby opens up, most
+// often right after reset_lobby_state_nolock, queued clients are seated
+// from the front, and their sessions take over the open FIFO ends.
+
+#define WAITING_ROOM_MAX 64
+
+static JoinRequest waiting[WAITING_ROOM_MAX];
+static int waiting_count;
+static int waiting_epfd = -1;               // main loop's epoll set
+
+static void waiting_send_position(int i) {
+    ProtoMsg m;
+    proto_begin(&m, MSG_QUEUED);
+    proto_put_i16(&m, i + 1);
+    proto_put_i16(&m, waiting_count);
+    size_t len = proto_end(&m);
+    ssize_t r = write(waiting[i].write_fd, m.data, len);   // full pipe: next update
+    (void)r;
+}
+
+// Take entry i out of the queue; its FIFO ends stay open
+static JoinRequest waiting_take(int i) {
+    JoinRequest req = waiting[i];
+    epoll_ctl(waiting_epfd, EPOLL_CTL_DEL, req.read_fd, NULL);
+    memmove(&waiting[i], &waiting[i + 1], (size_t)(waiting_count - i - 1) * sizeof(JoinRequest));
+    waiting_count--;
+    return req;
+}
+
+static void waiting_update_from(int i) {
+    for (; i < waiting_count; i++) waiting_send_position(i);
+}
+
+// Queue a request at the back. Returns -1 if the room is full or the
+// client's FIFOs could not be opened.
+static int waiting_enqueue(JoinRequest *req) {
+    if (waiting_count == WAITING_ROOM_MAX) return -1;
+
+    char client_read_fifo[sizeof(req->fifo) + 8];
+    snprintf(client_read_fifo, sizeof(client_read_fifo), "%s_read", req->fifo);
+    req->write_fd = open(req->fifo, O_WRONLY);
+    req->read_fd  = open(client_read_fifo, O_RDONLY | O_NONBLOCK);
+    if (req->write_fd < 0 || req->read_fd < 0) {
+        if (req->write_fd >= 0) close(req->write_fd);
+        if (req->read_fd >= 0) close(req->read_fd);
+        return -1;
+    }
+    // A client that stops reading must not stall the server
+    fcntl(req->write_fd, F_SETFL, fcntl(req->write_fd, F_GETFL) | O_NONBLOCK);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = 0;                          // hangups are always reported
+    ev.data.fd = req->read_fd;
+    epoll_ctl(waiting_epfd, EPOLL_CTL_ADD, req->read_fd, &ev);
+
+    waiting[waiting_count++] = *req;
+    waiting_update_from(0);                 // everyone's "of N" changed
+    printf("[QUEUE] All lobbies busy - client queued at position %d\n", waiting_count);
+    return 0;
+}
+
+// A queued client hung up (epoll event on its read FIFO). Returns 0 if
+// `fd` is not one of the queue's.
+static int waiting_room_hangup(int fd) {
+    for (int i = 0; i < waiting_count; i++) {
+        if (waiting[i].read_fd != fd) continue;
+        JoinRequest req = waiting_take(i);
+        close(req.write_fd);
+        close(req.read_fd);
+        printf("[QUEUE] Client at position %d left (%d waiting)\n", i + 1, waiting_count);
+        waiting_update_from(0);
+        return 1;
+    }
+    return 0;
+}
+
+// A forked session only keeps its own client's FIFOs
+static void waiting_room_close_inherited(void) {
+    for (int i = 0; i < waiting_count; i++) {
+        close(waiting[i].write_fd);
+        close(waiting[i].read_fd);
+    }
+    waiting_count = 0;
+}
+
+// Run the session for a seat the caller has marked connected
+static void start_session(int lobby, int player_id, JoinRequest *req, int rejoin) {
+    // The session does its own blocking (fork) or epoll-driven (pool) I/O
+    if (req->write_fd >= 0) fcntl(req->write_fd, F_SETFL, fcntl(req->write_fd, F_GETFL) & ~O_NONBLOCK);
+
+    if (pool_mode) {
+        if (pool_add_session(game_state, player_id, req, rejoin) < 0) {
+            perror("session allocation failed");
+            pthread_mutex_lock(&game_state->match_mutex);
+            game_state->player_connected[player_id] = 0;
+            game_state->active_players--;
+            lobby_changed_nolock();
+            pthread_mutex_unlock(&game_state->match_mutex);
+            reject_request(req, "Server: internal error (out of memory)\n");
+        }
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->player_connected[player_id] = 0;
+        game_state->active_players--;
+        lobby_changed_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
+        reject_request(req, "Server: internal error (fork failed)\n");
+    } else if (pid == 0) {
+        // Only the server process needs to survive writes to a vanished
+        // client; a child still dies on one and is reaped like any other
+        signal(SIGPIPE, SIG_DFL);
+        waiting_room_close_inherited();
+        handle_client(player_id, req, rejoin);
+        exit(0);
+    } else {
+        if (req->write_fd >= 0) close(req->write_fd);
+        if (req->read_fd >= 0) close(req->read_fd);
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->child_pid[player_id] = pid;
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        printf("[FORK] Created child process PID %d for Player %d (lobby %d)\n",
+               pid, player_id + 1, lobby + 1);
+    }
+}
+
+// Give the client a free seat in `lobby`. Returns -1 if there is none.
+static int seat_client(int lobby, JoinRequest *req) {
+    game_state = &arena->lobbies[lobby];
+
+    pthread_mutex_lock(&game_state->match_mutex);
+    int player_id = -1;
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        if (!game_state->player_connected[p]) {
+            player_id = p;
+            game_state->player_connected[p] = 1;
+            game_state->active_players++;
+            if (game_state->host_player_id < 0) game_state->host_player_id = p;
+            break;
+        }
+    }
+    int connected_now = game_state->active_players;
+    pthread_mutex_unlock(&game_state->match_mutex);
+
+    if (player_id == -1) return -1;
+
+    printf("[CONNECTION] Lobby %d: Player %d assigned (%d/%d connected)\n",
+           lobby + 1, player_id + 1, connected_now, MAX_PLAYERS);
+
+    start_session(lobby, player_id, req, 0);
+    return 0;
+}
+
+// Seat queued clients, front first, while lobbies have room
+static void admit_waiting(LobbyControl *ctl) {
+    int admitted = 0;
+    while (waiting_count > 0) {
+        int lobby = find_open_lobby(ctl);
+        if (lobby < 0) break;
+
+        JoinRequest req = waiting_take(0);
+        printf("[QUEUE] Admitting the first queued client -> lobby %d\n", lobby + 1);
+        if (seat_client(lobby, &req) < 0) {
+            memmove(&waiting[1], &waiting[0], (size_t)waiting_count * sizeof(JoinRequest));
+            waiting[0] = req;
+            waiting_count++;
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.data.fd = req.read_fd;
+            epoll_ctl(waiting_epfd, EPOLL_CTL_ADD, req.read_fd, &ev);
+            break;
+        }
+        admitted++;
+    }
+    if (admitted) waiting_update_from(0);
+}
+
+static void accept_client(LobbyControl *ctl, JoinRequest *req) {
+    int player_id = -1;
+    int lobby = req->token ? claim_held_seat(req->token, &player_id) : -1;
+    if (lobby >= 0) {
+        printf("[CONNECTION] Lobby %d: Player %d is back in their seat\n", lobby + 1, player_id + 1);
+        start_session(lobby, player_id, req, 1);
+        return;
+    }
+
+    // Nobody jumps the queue
+    lobby = waiting_count > 0 ? -1 : find_open_lobby(ctl);
+    if (lobby >= 0) {
+        printf("[CONNECTION] New connection request -> lobby %d\n", lobby + 1);
+        if (seat_client(lobby, req) == 0) return;
+    }
+
+    if (waiting_enqueue(req) < 0) {
+        printf("[CONNECTION] Rejected - waiting room full\n");
+        reject_request(req, "Server: Full (all lobbies are busy and the waiting room is full). "
+                            "Try again later.\n");
+    }
+}
+
+// A seat token only has to be hard to guess; 0 means "no token"
+static uint64_t new_seat_token(void) {
+    static uint64_t fallback;
+    uint64_t t = 0;
+    while (t == 0) {
+        if (getrandom(&t, sizeof(t), GRND_NONBLOCK) != (ssize_t)sizeof(t)) {
+            if (fallback == 0) fallback = run_seed ^ ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL);
+            t = rng_splitmix64(&fallback);
         }
+    }
+    return t;
+}
 
-        update_section_flags_nolock(player_id);
-        maybe_award_upper_bonus_nolock(player_id);
+// Start, finish and reset one lobby's match
+static void service_lobby(int lobby, LobbyControl *c) {
+    game_state = &arena->lobbies[lobby];
 
-        pthread_mutex_unlock(&game_state->game_mutex);
+    // Start game when host has chosen target and enough players are connected
+    pthread_mutex_lock(&game_state->match_mutex);
+    int target = game_state->target_players;
 
-        // Scoring selection 
-        if (game_state->skip_scoring[player_id] == 'N') {
-            snprintf(buffer, sizeof(buffer), "\n=== SCORING OPTIONS ===\n");
-            write(write_fd, buffer, strlen(buffer));
+    if (!c->scheduler_created && !game_state->game_started && target > 0 && game_state->bot_fill &&
+        game_state->active_players < target) {
+        seat_bots_nolock(game_state->bot_fill);
+    }
+    int connected = game_state->active_players;
 
-            if (game_state->lower_section_only[player_id] == 'N') {
-                for (int i = 0; i < 13; i++) {
-                    if (game_state->player_scores[player_id][i][1] == 0) {
-                        snprintf(buffer, sizeof(buffer), "%2d. %-20s | %d points\n",
-                                 i + 1, categories[i],
-                                 game_state->player_scores[player_id][i][2]);
-                        write(write_fd, buffer, strlen(buffer));
-                    }
-                }
+    if (!c->scheduler_created && !game_state->game_started && target > 0 && connected >= target) {
+        game_state->participants_count = 0;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            if (game_state->player_connected[p] && game_state->participants_count < target) {
+                game_state->participants[p] = 1;
+                game_state->participants_count++;
             } else {
-                for (int i = 6; i < 13; i++) {
-                    if (game_state->player_scores[player_id][i][1] == 0) {
-                        snprintf(buffer, sizeof(buffer), "%2d. %-20s | %d points\n",
-                                 i + 1, categories[i],
-                                 game_state->player_scores[player_id][i][2]);
-                        write(write_fd, buffer, strlen(buffer));
-                    }
-                }
+                game_state->participants[p] = 0;
             }
+            game_state->player_done[p] = 0;
+            game_state->final_scores[p] = 0;
+        }
+        game_state->winner_id = -1;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            int human = game_state->participants[p] && !game_state->player_bot[p];
+            game_state->seat_token[p] = human ? new_seat_token() : 0;
+        }
+        seed_match_nolock(matches_seeded++);
+        journal_match_start_nolock();
+        uint64_t seed = game_state->match_seed;
+
+        game_state->game_started = 1;
+        lobby_changed_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        pthread_create(&c->scheduler_tid, NULL, scheduler_thread, game_state);
+        c->scheduler_created = 1;
+
+        printf("\n*** LOBBY %d: GAME STARTING with %d players! (seed 0x%016llx) ***\n\n",
+               lobby + 1, target, (unsigned long long)seed);
+        char seed_msg[96];
+        snprintf(seed_msg, sizeof(seed_msg), "Lobby %d match seed 0x%016llx\n",
+                 lobby + 1, (unsigned long long)seed);
+        log_message(seed_msg);
+    } else {
+        pthread_mutex_unlock(&game_state->match_mutex);
+    }
 
-            int valid = 0, choice = -1;
-            while (!valid) {
-                if (game_state->lower_section_only[player_id] == 'N') {
-                    snprintf(buffer, sizeof(buffer), "\nChoose category (1-13): ");
-                } else {
-                    snprintf(buffer, sizeof(buffer), "\nChoose LOWER category (7-13): ");
-                }
-                write(write_fd, buffer, strlen(buffer));
+    // If a game finished, scheduler will stop
+    if (c->scheduler_created && !c->reset_pending) {
+        pthread_mutex_lock(&game_state->match_mutex);
+        int finished = game_state->game_finished;
+        pthread_mutex_unlock(&game_state->match_mutex);
 
-                n = timed_read_line(read_fd, recv_buffer, sizeof(recv_buffer), &deadline);
-                if (n == -2) { forfeit_turn_timeout(player_id, write_fd); goto next_turn; }
-                if (n <= 0) child_mark_disconnect_and_exit(player_id, write_fd, read_fd);
-                recv_buffer[n] = '\0';
+        if (finished) {
+            pthread_join(c->scheduler_tid, NULL);
+            c->scheduler_created = 0;
+            c->reset_pending = 1;
+        }
+    }
 
-                choice = atoi(recv_buffer);
+    if (c->reset_pending) {
+        pthread_mutex_lock(&game_state->match_mutex);
+        int ap = game_state->active_players;
+        pthread_mutex_unlock(&game_state->match_mutex);
 
-                if (game_state->lower_section_only[player_id] == 'Y' && choice < 7) {
-                    valid = 0;
-                } else if (choice >= 1 && choice <= 13 &&
-                           game_state->player_scores[player_id][choice - 1][1] == 0) {
-                    valid = 1;
-                } else {
-                    snprintf(buffer, sizeof(buffer), "Invalid choice! Try again.\n");
-                    write(write_fd, buffer, strlen(buffer));
-                }
-            }
+        if (ap == 0) {
+            pthread_mutex_lock(&game_state->match_mutex);
+            reset_lobby_state_nolock();
+            pthread_mutex_unlock(&game_state->match_mutex);
 
-            if (valid && apply_score(player_id, choice - 1)) {
-                snprintf(buffer, sizeof(buffer), "Scored %d points in %s!\n",
-                         game_state->player_scores[player_id][choice - 1][0],
-                         categories[choice - 1]);
-                write(write_fd, buffer, strlen(buffer));
-            }
+            c->reset_pending = 0;
+            printf("\n[SERVER] Lobby %d reset. Waiting for new players...\n", lobby + 1);
         }
+    }
+}
 
-        // If player just finished mark as done
-        pthread_mutex_lock(&game_state->game_mutex);
-        if (player_finished_nolock(player_id)) game_state->player_done[player_id] = 1;
-        maybe_end_game_nolock();
-        pthread_mutex_unlock(&game_state->game_mutex);
-
-        // Show current scorecard
-        pthread_mutex_lock(&game_state->game_mutex);
-
-        snprintf(buffer, sizeof(buffer), "\nCurrent Score:\nUpper Section\n");
-        write(write_fd, buffer, strlen(buffer));
-        for (int i = 0; i < 6; i++) {
-            snprintf(buffer, sizeof(buffer), "%2d. %-14s | %d %s\n",
-                     i + 1, categories[i], game_state->player_scores[player_id][i][0],
-                     (game_state->player_scores[player_id][i][1] ? "(Scored)" : "(Unscored)"));
-            write(write_fd, buffer, strlen(buffer));
-        }
-
-        snprintf(buffer, sizeof(buffer), "\nLower Section\n");
-        write(write_fd, buffer, strlen(buffer));
-        for (int i = 6; i < 13; i++) {
-            snprintf(buffer, sizeof(buffer), "%2d. %-14s | %d %s\n",
-                     i + 1, categories[i], game_state->player_scores[player_id][i][0],
-                     (game_state->player_scores[player_id][i][1] ? "(Scored)" : "(Unscored)"));
-            write(write_fd, buffer, strlen(buffer));
-        }
-
-        int upper_total = 0;
-        for (int i = 0; i < 6; i++) upper_total += game_state->player_scores[player_id][i][0];
-
-        if (game_state->bonus_achieved[player_id] == 'N') {
-            int pts_to_bonus = (upper_total < 63) ? (63 - upper_total) : 0;
-            snprintf(buffer, sizeof(buffer),
-                     "\nYou need %d more points in the UPPER SECTION to receive the 35-point bonus.\n",
-                     pts_to_bonus);
-            write(write_fd, buffer, strlen(buffer));
-        } else {
-            snprintf(buffer, sizeof(buffer),
-                     "\nUpper bonus achieved! (+35)\n");
-            write(write_fd, buffer, strlen(buffer));
+// --resume: bring back every match the checkpoint file holds. Bots take
+// their seats again straight away; a human seat is held for
+// RESUME_GRACE_SECONDS for its player to reconnect with the seat token.
+// Each match carries on with the turn after the last one completed.
+// Without --resume the slots are cleared instead. Returns matches restored.
+static int restore_matches(LobbyControl *ctl, int resume) {
+    MatchCheckpoint m;
+    int restored = 0;
+
+    for (int l = 0; l < arena->num_lobbies; l++) {
+        long len = ckpt_read(checkpoint, l, &m, sizeof(m));
+        if (!resume || len != (long)sizeof(m) || m.version != CHECKPOINT_VERSION || !m.active) {
+            if (len >= 0) {
+                memset(&m, 0, sizeof(m));
+                m.version = CHECKPOINT_VERSION;
+                ckpt_write(checkpoint, l, &m, sizeof(m));
+            }
+            continue;
         }
 
-        if (game_state->player_scores[player_id][14][1] == 1) {
-            snprintf(buffer, sizeof(buffer),
-                     "Yahtzee bonus total: %d\n", game_state->player_scores[player_id][14][0]);
-            write(write_fd, buffer, strlen(buffer));
+        for (int p = 0; p < MAX_PLAYERS; p++) m.player_names[p][NAME_SIZE - 1] = '\0';
+
+        game_state = &arena->lobbies[l];
+        struct timespec hold;
+        clock_gettime(CLOCK_REALTIME, &hold);
+        hold.tv_sec += RESUME_GRACE_SECONDS;
+
+        pthread_mutex_lock(&game_state->match_mutex);
+        game_state->match_no = m.match_no;
+        game_state->match_seed = m.match_seed;
+        game_state->current_turn = m.next_turn % MAX_PLAYERS;
+        game_state->participants_count = m.participants_count;
+        game_state->target_players = m.participants_count;
+        game_state->winner_id = -1;
+        memcpy(game_state->participants, m.participants, sizeof(m.participants));
+        memcpy(game_state->player_done, m.player_done, sizeof(m.player_done));
+        memcpy(game_state->player_names, m.player_names, sizeof(m.player_names));
+        memcpy(game_state->seat_token, m.seat_token, sizeof(m.seat_token));
+        if (m.matches_seeded > matches_seeded) matches_seeded = m.matches_seeded;
+
+        unsigned char start[9];
+        memcpy(start, &m.match_seed, 8);
+        start[8] = 0;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            if (m.participants[p]) start[8] |= (unsigned char)(1 << p);
         }
+        journal_event(JNL_RESUME, 0, start, sizeof(start));
 
-        pthread_mutex_unlock(&game_state->game_mutex);
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            if (!m.participants[p]) continue;
+
+            pthread_mutex_lock(&game_state->player_mutex[p]);
+            game_state->player_rng[p] = m.player_rng[p];
+            game_state->player_draws[p] = m.player_draws[p];
+            memcpy(game_state->player_scores[p], m.player_scores[p], sizeof(m.player_scores[p]));
+            game_state->yahtzee_achieved[p] = m.yahtzee_achieved[p];
+            game_state->amount_yahtzee[p] = m.amount_yahtzee[p];
+            game_state->required_upper_section[p] = m.required_upper_section[p];
+            game_state->bonus_achieved[p] = m.bonus_achieved[p];
+            game_state->turn_phase[p] = TURN_IDLE;  // checkpoints fall between turns
+            update_section_flags_plocked(p);
+            publish_player_plocked(p);
+
+            // The scorecard the match resumes from, for journal_replay
+            unsigned char seat[37];
+            uint16_t used = 0;
+            int16_t bonus = (int16_t)m.player_scores[p][14][0];
+            for (int c = 0; c < 13; c++) {
+                int16_t pts = (int16_t)m.player_scores[p][c][0];
+                if (m.player_scores[p][c][1] == 1) used |= (uint16_t)(1 << c);
+                memcpy(seat + 11 + 2 * c, &pts, 2);
+            }
+            memcpy(seat, &m.player_draws[p], 4);
+            memcpy(seat + 4, &used, 2);
+            memcpy(seat + 6, &bonus, 2);
+            seat[8] = m.yahtzee_achieved[p] == 'Y';
+            seat[9] = (unsigned char)m.amount_yahtzee[p];
+            seat[10] = (unsigned char)(signed char)m.required_upper_section[p];
+            pthread_mutex_unlock(&game_state->player_mutex[p]);
+            journal_event(JNL_SEAT, p, seat, sizeof(seat));
+
+            if (m.player_done[p]) continue;
+            if (m.player_bot[p]) {
+                if (spawn_bot_nolock(p, m.player_bot[p], SESS_WAIT_TURN) < 0) {
+                    forfeit_remaining_on_disconnect_nolock(p);
+                }
+            } else {
+                game_state->reserve_until[p] = hold;
+            }
+        }
 
-        snprintf(buffer, sizeof(buffer), "Turn complete. Waiting for other players...\n");
-        write(write_fd, buffer, strlen(buffer));
+        game_state->game_started = 1;
+        lobby_changed_nolock();
+        pthread_mutex_unlock(&game_state->match_mutex);
 
-        sem_post(&game_state->turn_done_sem[player_id]);
+        pthread_create(&ctl[l].scheduler_tid, NULL, scheduler_thread, game_state);
+        ctl[l].scheduler_created = 1;
+        restored++;
 
-    next_turn:
-        ;
+        printf("*** LOBBY %d: resumed match %u (seed 0x%016llx) with %d players ***\n",
+               l + 1, m.match_no, (unsigned long long)m.match_seed, m.participants_count);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Lobby %d resumed match seed 0x%016llx\n",
+                 l + 1, (unsigned long long)m.match_seed);
+        log_message(msg);
     }
+    return restored;
+}
 
-    // GAME OVER output
-    pthread_mutex_lock(&game_state->game_mutex);
-    int winner = game_state->winner_id;
-    int my_final = game_state->final_scores[player_id];
-    int finished = game_state->game_finished;
-    pthread_mutex_unlock(&game_state->game_mutex);
+// A child that died without running its own disconnect path still owns a seat
+static void reap_children(void) {
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        printf("[SYSTEM] Child process %d reaped\n", pid);
 
-    if (finished) {
-        pthread_mutex_lock(&game_state->game_mutex);
-        snprintf(buffer, sizeof(buffer),
-                 "\n=== GAME OVER ===\nYour final score: %d\n",
-                 my_final);
-        write(write_fd, buffer, strlen(buffer));
-
-        if (winner >= 0) {
-            snprintf(buffer, sizeof(buffer),
-                     "Winner: %s (Player %d) with %d\n",
-                     game_state->player_names[winner], winner + 1,
-                     game_state->final_scores[winner]);
-            write(write_fd, buffer, strlen(buffer));
-        } else {
-            write(write_fd, "Winner: N/A\n", 12);
-        }
+        for (int l = 0; l < arena->num_lobbies; l++) {
+            game_state = &arena->lobbies[l];
+            pthread_mutex_lock(&game_state->match_mutex);
+            int player_id = -1;
+            for (int p = 0; p < MAX_PLAYERS; p++) {
+                if (game_state->child_pid[p] == pid) player_id = p;
+            }
+            if (player_id >= 0) mark_disconnected_nolock(player_id);
+            pthread_mutex_unlock(&game_state->match_mutex);
 
-        write(write_fd, "\nFinal Scores:\n", 14);
-        for (int p = 0; p < MAX_PLAYERS; p++) {
-            if (!game_state->participants[p]) continue;
-            snprintf(buffer, sizeof(buffer), "Player %d (%s): %d\n",
-                     p + 1, game_state->player_names[p], game_state->final_scores[p]);
-            write(write_fd, buffer, strlen(buffer));
+            if (player_id >= 0) {
+                printf("[SYSTEM] Lobby %d: Player %d lost (child exited)\n", l + 1, player_id + 1);
+                sem_post(&game_state->turn_done_sem[player_id]);
+            }
         }
-        pthread_mutex_unlock(&game_state->game_mutex);
-    }
-
-    pthread_mutex_lock(&game_state->game_mutex);
-    if (game_state->player_connected[player_id]) {
-        game_state->player_connected[player_id] = 0;
-        if (game_state->active_players > 0) game_state->active_players--;
     }
-    game_state->child_pid[player_id] = -1;
-    pthread_mutex_unlock(&game_state->game_mutex);
-
-    snprintf(buffer, sizeof(buffer), "Disconnecting...\n");
-    write(write_fd, buffer, strlen(buffer));
-
-    close(write_fd);
-    close(read_fd);
-
-    printf("[SYSTEM] Player %d (%s) disconnected\n",
-           player_id + 1, game_state->player_names[player_id]);
-    exit(0);
 }
 
-// RR Scheduler
-
-void* scheduler_thread(void* arg) {
+// Hint worker: evaluates the turn each player is on (hint.h) so the hint
+// command in a session is only ever a copy and a few lookups. Sessions in
+// every lobby, forked or pooled, post to it through the shared arena.
+static void *hint_thread_func(void *arg) {
     (void)arg;
-    printf("[SCHEDULER] RR Scheduler started (quantum=%ds)\n", QUANTUM_SECONDS);
-
-    int turn_index = 0;
-
     while (1) {
-        pthread_mutex_lock(&game_state->game_mutex);
-
-        if (game_state->game_finished) {
-            pthread_mutex_unlock(&game_state->game_mutex);
-            break;
+        uint32_t sig = atomic_load(&arena->hint_signal);
+        for (int l = 0; l < arena->num_lobbies; l++) {
+            hint_service(arena->lobbies[l].hints, MAX_PLAYERS, &strategy);
         }
+        futex_wait(&arena->hint_signal, sig, -1);
+    }
+    return NULL;
+}
 
-        // Find next schedulable player
-        int start = turn_index;
-        int found = 0;
-
-        while (1) {
-            int is_participant = game_state->participants[turn_index];
-            int is_connected   = game_state->player_connected[turn_index];
-            int is_done        = game_state->player_done[turn_index];
-
-            if (is_participant && !is_connected && !is_done) {
-                // If participant disconnected mid-game, forfeit them
-                forfeit_remaining_on_disconnect_nolock(turn_index);
-                is_done = game_state->player_done[turn_index];
-            }
+static void read_connection_requests(int server_fd, LobbyControl *ctl,
+                                     char *accum, size_t accum_cap, size_t *accum_len) {
+    while (1) {
+        char buf[256];
+        int n = (int)read(server_fd, buf, sizeof(buf));
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            perror("read server FIFO");
+        }
+        if (n <= 0) return;
+
+        size_t to_copy = (size_t)n;
+        if (*accum_len + to_copy >= accum_cap) *accum_len = 0;
+        memcpy(accum + *accum_len, buf, to_copy);
+        *accum_len += to_copy;
+
+        size_t start = 0;
+        for (size_t i = 0; i < *accum_len; i++) {
+            if (accum[i] == '\n') {
+                char client_fifo[256];
+                size_t line_len = i - start;
+                if (line_len >= sizeof(client_fifo)) line_len = sizeof(client_fifo) - 1;
+                memcpy(client_fifo, accum + start, line_len);
+                client_fifo[line_len] = '\0';
+                start = i + 1;
+
+                if (client_fifo[0] == '\0') continue;
+
+                // "<fifo path> [ring=<shm name>] [token=<seat token>]"
+                JoinRequest req;
+                memset(&req, 0, sizeof(req));
+                req.write_fd = req.read_fd = -1;
+                char *save = NULL;
+                snprintf(req.fifo, sizeof(req.fifo), "%s", strtok_r(client_fifo, " ", &save));
+                for (char *opt; (opt = strtok_r(NULL, " ", &save)); ) {
+                    if (strncmp(opt, "ring=", 5) == 0) snprintf(req.ring, sizeof(req.ring), "%s", opt + 5);
+                    else if (strncmp(opt, "token=", 6) == 0) req.token = strtoull(opt + 6, NULL, 16);
+                }
 
-            if (is_participant && is_connected && !is_done) {
-                found = 1;
-                break;
+                accept_client(ctl, &req);
             }
-
-            turn_index = (turn_index + 1) % MAX_PLAYERS;
-            if (turn_index == start) break;
         }
 
-        if (!found) {
-            maybe_end_game_nolock();
-            pthread_mutex_unlock(&game_state->game_mutex);
-            nanosleep(&(struct timespec){0, 100000000}, NULL);
-            continue;
+        if (start > 0) {
+            memmove(accum, accum + start, *accum_len - start);
+            *accum_len -= start;
         }
+    }
+}
 
-        game_state->current_turn = turn_index;
-        game_state->turn_active[turn_index] = 1;
-        pthread_mutex_unlock(&game_state->game_mutex);
-
-        printf("[SCHEDULER] Turn -> Player %d (%ds quantum)\n",
-               turn_index + 1, QUANTUM_SECONDS);
+// Headless simulation (--simulate N)
+//
+// Complete games between bots with no clients, FIFOs, scheduler or
+// quantum. Each worker thread owns a private GameState and walks its bot
+// sessions through turns in seat order, so every game goes through the
+// live code: session_run's turn flow, the Yahtzee bonus/Joker rules,
+// apply_score, the upper bonus and finalize_game_nolock. Games are
+// sharded evenly over the threads, and game g is seeded like the g-th
+// live match under the same --seed. Bots get no CPU budget unless
+// --bot-budget-us is given, so a run is repeatable for a given seed
+// whatever the thread count.
 
-        struct timespec now;
-        clock_gettime(CLOCK_REALTIME, &now);
-        pthread_mutex_lock(&game_state->game_mutex);
-        game_state->turn_deadline[turn_index] = now;
-        game_state->turn_deadline[turn_index].tv_sec += QUANTUM_SECONDS;
-        pthread_mutex_unlock(&game_state->game_mutex);
+#define SIM_MAX_SCORE 1600
 
+typedef struct {
+    int id;
+    long games;
+    long first_game;                            // index of this worker's first game
+    int seats;
+    const BotLevel *levels;
+    pthread_t tid;
+
+    long hist[MAX_PLAYERS][SIM_MAX_SCORE + 1];  // final score counts per seat
+    long wins[MAX_PLAYERS];
+    long bonus[MAX_PLAYERS];                    // games with the upper bonus
+    long yahtzee[MAX_PLAYERS];                  // games with at least one Yahtzee
+} SimWorker;
+
+static void *sim_worker(void *arg) {
+    SimWorker *w = (SimWorker*)arg;
+
+    game_state = (GameState*)calloc(1, sizeof(GameState));
+    Session *seat[MAX_PLAYERS] = {0};
+    Bot *bots = (Bot*)calloc((size_t)w->seats, sizeof(Bot));
+    if (!game_state || !bots) {
+        perror("simulation allocation failed");
+        exit(1);
+    }
+    init_lobby_state(w->id);
 
-        // Avoid late posts from previous turn instantly completing next turn
-        while (sem_trywait(&game_state->turn_done_sem[turn_index]) == 0) {
+    for (int p = 0; p < w->seats; p++) {
+        seat[p] = session_create(game_state, p, "", NULL);
+        if (!seat[p]) {
+            perror("simulation allocation failed");
+            exit(1);
         }
+        bot_init(&bots[p], w->levels[p], bot_budget_ns);
+        seat[p]->bot = &bots[p];
+    }
 
-        pthread_mutex_lock(&game_state->game_mutex);
-        game_state->force_end_turn[turn_index] = 0;
-        pthread_mutex_unlock(&game_state->game_mutex);
+    for (long g = 0; g < w->games; g++) {
+        pthread_mutex_lock(&game_state->match_mutex);
+        reset_lobby_state_nolock();
+        seed_match_nolock((uint64_t)(w->first_game + g));
+        for (int p = 0; p < w->seats; p++) {
+            game_state->participants[p] = 1;
+            game_state->player_connected[p] = 1;
+            game_state->player_bot[p] = w->levels[p];
+            snprintf(game_state->player_names[p], NAME_SIZE, "Bot%d-%s", p + 1,
+                     bot_level_name(w->levels[p]));
+
+            // No quantum: the deadline is a day away
+            clock_gettime(CLOCK_REALTIME, &game_state->turn_deadline[p]);
+            game_state->turn_deadline[p].tv_sec += 86400;
+        }
+        game_state->active_players = game_state->target_players = w->seats;
+        game_state->participants_count = w->seats;
+        journal_match_start_nolock();
+        game_state->game_started = 1;
+        pthread_mutex_unlock(&game_state->match_mutex);
+
+        // Round robin in seat order, one whole turn per session_run
+        while (!game_state->game_finished) {
+            for (int p = 0; p < w->seats && !game_state->game_finished; p++) {
+                if (game_state->player_done[p]) continue;
+                seat[p]->state = SESS_WAIT_TURN;
+                seat[p]->turn_granted = 1;
+                session_run(seat[p]);
+                seat[p]->outlen = 0;
+            }
+        }
 
-        sem_post(&game_state->turn_sem[turn_index]);
+        for (int p = 0; p < w->seats; p++) {
+            int score = game_state->final_scores[p];
+            w->hist[p][score < 0 ? 0 : score > SIM_MAX_SCORE ? SIM_MAX_SCORE : score]++;
+            w->bonus[p] += game_state->bonus_achieved[p] == 'Y';
+            w->yahtzee[p] += game_state->amount_yahtzee[p] > 0;
+        }
+        if (game_state->winner_id >= 0) w->wins[game_state->winner_id]++;
+    }
 
-        int r = wait_turn_done_or_disconnect(turn_index, QUANTUM_SECONDS);
+    for (int p = 0; p < w->seats; p++) free(seat[p]);
+    free(bots);
+    free(game_state);
+    return NULL;
+}
 
-        pthread_mutex_lock(&game_state->game_mutex);
-        game_state->turn_active[turn_index] = 0;
-        pthread_mutex_unlock(&game_state->game_mutex);
+// Score at quantile q of a histogram holding n results
+static int sim_quantile(const long *hist, long n, double q) {
+    long want = (long)(q * (double)(n - 1)), seen = 0;
+    for (int v = 0; v <= SIM_MAX_SCORE; v++) {
+        seen += hist[v];
+        if (seen > want) return v;
+    }
+    return SIM_MAX_SCORE;
+}
 
-        if (r == -1) {
-            printf("[SCHEDULER] Player %d quantum expired\n", turn_index + 1);
+static int run_simulation(long games, int threads,
+                          const BotLevel *levels, int seats) {
+    if (threads > games) threads = (int)games;
+    SimWorker *w = (SimWorker*)calloc((size_t)threads, sizeof(SimWorker));
+    long *hist = (long*)calloc((size_t)seats * (SIM_MAX_SCORE + 1), sizeof(long));
+    if (!w || !hist) {
+        perror("calloc");
+        return 1;
+    }
 
-            pthread_mutex_lock(&game_state->game_mutex);
-            pid_t cpid = game_state->child_pid[turn_index];
-            game_state->force_end_turn[turn_index] = 1;
-            pthread_mutex_unlock(&game_state->game_mutex);
+    quiet = 1;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    long first = 0;
+    for (int i = 0; i < threads; i++) {
+        w[i].id = i;
+        w[i].games = games / threads + (i < games % threads);
+        w[i].first_game = first;
+        first += w[i].games;
+        w[i].seats = seats;
+        w[i].levels = levels;
+        if (pthread_create(&w[i].tid, NULL, sim_worker, &w[i]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
 
-            if (cpid > 0) {
-                kill(cpid, SIGUSR1);
-            }
-        } else if (r == 1) {
-            printf("[SCHEDULER] Player %d disconnected during turn\n", turn_index + 1);
+    long wins[MAX_PLAYERS] = {0}, bonus[MAX_PLAYERS] = {0}, yahtzee[MAX_PLAYERS] = {0};
+    for (int i = 0; i < threads; i++) {
+        pthread_join(w[i].tid, NULL);
+        for (int p = 0; p < seats; p++) {
+            for (int v = 0; v <= SIM_MAX_SCORE; v++) hist[p * (SIM_MAX_SCORE + 1) + v] += w[i].hist[p][v];
+            wins[p] += w[i].wins[p];
+            bonus[p] += w[i].bonus[p];
+            yahtzee[p] += w[i].yahtzee[p];
+        }
+    }
 
-            // Immediately forfeit to prevent ghost turns and allow game to end
-            pthread_mutex_lock(&game_state->game_mutex);
-            if (game_state->participants[turn_index] && !game_state->player_done[turn_index]) {
-                forfeit_remaining_on_disconnect_nolock(turn_index);
-            }
-            pthread_mutex_unlock(&game_state->game_mutex);
-        } else {
-            printf("[SCHEDULER] Player %d completed their turn.\n", turn_index + 1);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double dt = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("Simulated %ld games of %d bots on %d thread%s (seed %llu): %.2f s, %.0f games/s\n\n",
+           games, seats, threads, threads == 1 ? "" : "s", (unsigned long long)run_seed, dt,
+           dt > 0 ? (double)games / dt : 0.0);
+
+    printf("Seat  Level     Mean     SD    p5   p50   p95   Max   Wins  Bonus  Yahtzee\n");
+    long all[SIM_MAX_SCORE + 1] = {0};
+    for (int p = 0; p < seats; p++) {
+        const long *h = &hist[p * (SIM_MAX_SCORE + 1)];
+        double sum = 0, sq = 0;
+        int max = 0;
+        for (int v = 0; v <= SIM_MAX_SCORE; v++) {
+            sum += (double)v * h[v];
+            sq += (double)v * v * h[v];
+            if (h[v]) max = v;
+            all[v] += h[v];
         }
+        double mean = sum / games;
+        double sd = sqrt(sq / games - mean * mean > 0 ? sq / games - mean * mean : 0);
+        printf("%4d  %-7s %6.1f %6.1f %5d %5d %5d %5d %5.1f%% %5.1f%%   %5.1f%%\n",
+               p + 1, bot_level_name(levels[p]), mean, sd, sim_quantile(h, games, 0.05),
+               sim_quantile(h, games, 0.5), sim_quantile(h, games, 0.95), max,
+               100.0 * wins[p] / games, 100.0 * bonus[p] / games, 100.0 * yahtzee[p] / games);
+    }
 
-        pthread_mutex_lock(&game_state->game_mutex);
-        maybe_end_game_nolock();
-        pthread_mutex_unlock(&game_state->game_mutex);
+    // Distribution over every seat in 25-point buckets
+    long total = games * seats, peak = 0;
+    long bucket[SIM_MAX_SCORE / 25 + 1] = {0};
+    int lo = -1, hi = 0;
+    for (int v = 0; v <= SIM_MAX_SCORE; v++) {
+        bucket[v / 25] += all[v];
+        if (all[v] && lo < 0) lo = v / 25;
+        if (all[v]) hi = v / 25;
+    }
+    for (int b = lo; b <= hi; b++) if (bucket[b] > peak) peak = bucket[b];
 
-        turn_index = (turn_index + 1) % MAX_PLAYERS;
+    printf("\nScore distribution (all seats):\n");
+    for (int b = lo; b >= 0 && b <= hi; b++) {
+        int bar = peak ? (int)(50 * bucket[b] / peak) : 0;
+        printf("  %4d-%-4d %6.2f%% %.*s\n", b * 25, b * 25 + 24, 100.0 * bucket[b] / total, bar,
+               "##################################################");
     }
 
-    printf("[SCHEDULER] Scheduler ending\n");
-    return NULL;
+    free(hist);
+    free(w);
+    return 0;
 }
 
-// Lobby Reset
-static void reset_lobby_state_nolock(void) {
-    game_state->current_turn   = 0;
-    game_state->active_players = 0;
-    game_state->target_players = 0;
-    game_state->host_player_id = -1;
-    game_state->game_started   = 0;
-    game_state->game_round     = 1;
-    game_state->game_finished  = 0;
-    game_state->winner_id      = -1;
-    game_state->participants_count = 0;
-
-    for (int p = 0; p < MAX_PLAYERS; p++) {
-        game_state->participants[p] = 0;
-        game_state->player_done[p] = 0;
-        game_state->final_scores[p] = 0;
-        game_state->player_connected[p] = 0;
-        game_state->child_pid[p] = -1;
-        game_state->force_end_turn[p] = 0;
+// "easy,medium,hard" or "1,2,3"; returns the number of seats, 0 if invalid
+static int parse_bot_levels(const char *list, BotLevel *levels) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", list);
+
+    int n = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        if (n == MAX_PLAYERS) return 0;
+        BotLevel lv = BOT_NONE;
+        for (int l = BOT_EASY; l < BOT_LEVELS; l++) {
+            if (strcmp(tok, bot_level_name((BotLevel)l)) == 0 || atoi(tok) == l) lv = (BotLevel)l;
+        }
+        if (lv == BOT_NONE) return 0;
+        levels[n++] = lv;
+    }
+    return n;
+}
 
-        // wipe match scorecard
-        for (int i = 0; i < 15; i++)
-            for (int k = 0; k < 3; k++)
-                game_state->player_scores[p][i][k] = 0;
+// Main
 
-        // wipe per-match flags
-        game_state->yahtzee_achieved[p] = 'N';
-        game_state->amount_yahtzee[p] = 0;
-        game_state->required_upper_section[p] = -1;
-        game_state->lower_section_only[p] = 'N';
-        game_state->skip_scoring[p] = 'N';
-        game_state->bonus_achieved[p] = 'N';
-        game_state->upper_section_filled[p] = 'N';
-        game_state->lower_section_filled[p] = 'N';
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--lobbies N] [--mode fork|pool] [--workers N] [--bot-budget-us N]\n"
+                    "       [--seed S] [--journal FILE|none] [--checkpoint FILE|none] [--resume]\n"
+                    "       %s --simulate GAMES [--sim-bots easy,medium,hard] [--threads N] [--seed S]\n"
+                    "       [--journal FILE]\n",
+            prog, prog);
+}
 
-        memset(game_state->player_names[p], 0, NAME_SIZE);
+int main(int argc, char *argv[]) {
+    int num_lobbies = DEFAULT_LOBBIES;
+    int use_pool = 0;
+    int workers = 0;
 
-        while (sem_trywait(&game_state->turn_done_sem[p]) == 0) {}
+    long simulate = 0;
+    BotLevel sim_levels[MAX_PLAYERS] = {BOT_EASY, BOT_MEDIUM, BOT_HARD};
+    int sim_seats = 3;
+    int sim_threads = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t seed_clock = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    run_seed = rng_splitmix64(&seed_clock) ^ (uint64_t)getpid();
+    int budget_set = 0;
+    const char *journal_path = NULL;       // default: JOURNAL_FILE, none when simulating
+    const char *checkpoint_path = CHECKPOINT_FILE;
+    int resume = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lobbies") == 0 && i + 1 < argc) {
+            num_lobbies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            if (strcmp(mode, "pool") == 0) use_pool = 1;
+            else if (strcmp(mode, "fork") == 0) use_pool = 0;
+            else { usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bot-budget-us") == 0 && i + 1 < argc) {
+            bot_budget_ns = atol(argv[++i]) * 1000L;
+            budget_set = 1;
+        } else if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc) {
+            simulate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--sim-bots") == 0 && i + 1 < argc) {
+            sim_seats = parse_bot_levels(argv[++i], sim_levels);
+            if (sim_seats == 0) { usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            sim_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            run_seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resume = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_lobbies < 1) {
+        fprintf(stderr, "Number of lobbies must be at least 1\n");
+        return 1;
+    }
+    if (workers <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (ncpu > 0) ? (int)ncpu : POOL_DEFAULT_WORKERS;
     }
-}
 
-// Main
+    scoring_init();
 
-int main() {
-    srand((unsigned)time(NULL));
-    server_pid = getpid();
+    if (simulate > 0) {
+        if (sim_threads <= 0) sim_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (sim_threads <= 0) sim_threads = 1;
+        if (!budget_set) bot_budget_ns = 0;
+        if (journal_path && strcmp(journal_path, "none") != 0 && journal_open(journal_path, run_seed) < 0) {
+            perror(journal_path);
+            return 1;
+        }
+        if (solver_map(SOLVER_FILE, &strategy) < 0) {
+            fprintf(stderr, "No usable %s: hard bots play as medium\n", SOLVER_FILE);
+        }
+        int rc = run_simulation(simulate, sim_threads, sim_levels, sim_seats);
+        journal_close();
+        solver_unmap(&strategy);
+        return rc;
+    }
 
     printf("\n");
     printf("╔════════════════════════════════════════════╗\n");
@@ -1500,30 +3716,96 @@ int main() {
     printf("╚════════════════════════════════════════════╝\n");
     printf("\n");
 
-    if (init_shared_memory() < 0) {
+    if (init_shared_memory(num_lobbies) < 0) {
         fprintf(stderr, "Failed to initialize shared memory\n");
         return 1;
     }
 
-    // Start logger thread first, then load persisted scores
+    // Signal mask first so every thread (logger, schedulers) inherits it
+    int sig_fd = setup_signal_handlers();
+
+    // A client that vanishes mid-write (a rejection, a queue notice, or any
+    // pool session write) must not take the server down with it
+    signal(SIGPIPE, SIG_IGN);
+
+    notify_fd = eventfd(0, EFD_NONBLOCK);
+    if (notify_fd < 0) {
+        perror("eventfd failed");
+        return 1;
+    }
+
+    // Start logger thread first, then open the persisted scores
     pthread_create(&logger_thread_id, NULL, logger_thread_func, NULL);
     pthread_detach(logger_thread_id);
-    load_scores_from_file();
 
-    setup_signal_handlers();
+    int fresh_store;
+    score_store = store_open(SCORES_DB, &fresh_store);
+    if (!score_store) {
+        perror("Cannot open " SCORES_DB);
+        return 1;
+    }
+    if (fresh_store) import_legacy_scores();
+    publish_leaders();
+
+    if (!journal_path) journal_path = JOURNAL_FILE;
+    if (strcmp(journal_path, "none") != 0) {
+        if (journal_open(journal_path, run_seed) < 0) {
+            perror(journal_path);
+            return 1;
+        }
+        printf("✓ Match journal: %s\n", journal_path);
+    }
+
+    if (strcmp(checkpoint_path, "none") != 0) {
+        checkpoint = ckpt_open(checkpoint_path, num_lobbies, sizeof(MatchCheckpoint));
+        if (!checkpoint) {
+            perror(checkpoint_path);
+            return 1;
+        }
+        printf("✓ Match checkpoints: %s\n", checkpoint_path);
+    } else if (resume) {
+        fprintf(stderr, "--resume needs a checkpoint file\n");
+        return 1;
+    }
+
+    if (solver_map(SOLVER_FILE, &strategy) == 0) {
+        printf("✓ Strategy table mapped (optimal expected score %.2f)\n", strategy.hdr->start_value);
+
+        pthread_t hint_tid;
+        pthread_create(&hint_tid, NULL, hint_thread_func, NULL);
+        pthread_detach(hint_tid);
+    } else {
+        printf("No usable %s (run \"make strategy\"): optimal-play features disabled\n", SOLVER_FILE);
+    }
 
     if (setup_ipc_server() < 0) {
         fprintf(stderr, "Failed to setup IPC\n");
         return 1;
     }
 
-    printf("\nServer ready! Waiting for players...\n");
-    printf("Host (Player 1) will choose how many players to start (3-%d)\n", MAX_PLAYERS);
+    if (use_pool && pool_start(workers) < 0) {
+        fprintf(stderr, "Failed to start session pool\n");
+        return 1;
+    }
+
+    printf("\nServer ready! Waiting for players... (%s mode)\n", use_pool ? "pool" : "fork");
+    printf("Run seed 0x%016llx (--seed replays every match in start order)\n",
+           (unsigned long long)run_seed);
+    printf("Each lobby's host chooses how many players to start (3-%d)\n", MAX_PLAYERS);
     printf("----------------------------------------\n");
 
-    pthread_t scheduler_tid;
-    int scheduler_created = 0;
-    int reset_pending = 0;
+    LobbyControl *ctl = calloc((size_t)num_lobbies, sizeof(LobbyControl));
+    if (!ctl) {
+        perror("calloc lobby control");
+        return 1;
+    }
+    if (checkpoint) {
+        int restored = restore_matches(ctl, resume);
+        if (resume) {
+            printf("Resumed %d match%s; players have %ds to reconnect\n",
+                   restored, restored == 1 ? "" : "es", RESUME_GRACE_SECONDS);
+        }
+    }
 
     int server_fd = open(SERVER_FIFO, O_RDWR | O_NONBLOCK);
     if (server_fd < 0) {
@@ -1531,162 +3813,69 @@ int main() {
         return 1;
     }
 
+    // Every wakeup is an event: a connection request, a lobby change pushed
+    // by a child or scheduler, or a child exiting. No fixed polling interval.
+    int ep_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ep_fd < 0) {
+        perror("epoll_create1 failed");
+        return 1;
+    }
+    int watch_fds[3] = {server_fd, notify_fd, sig_fd};
+    for (int i = 0; i < 3; i++) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = watch_fds[i];
+        if (epoll_ctl(ep_fd, EPOLL_CTL_ADD, watch_fds[i], &ev) < 0) {
+            perror("epoll_ctl failed");
+            return 1;
+        }
+    }
+    waiting_epfd = ep_fd;
+
     char accum[2048];
     size_t accum_len = 0;
 
     while (1) {
-        char buf[256];
-        int n = (int)read(server_fd, buf, sizeof(buf));
-        if (n > 0) {
-            size_t to_copy = (size_t)n;
-            if (accum_len + to_copy >= sizeof(accum)) accum_len = 0;
-            memcpy(accum + accum_len, buf, to_copy);
-            accum_len += to_copy;
-
-            size_t start = 0;
-            for (size_t i = 0; i < accum_len; i++) {
-                if (accum[i] == '\n') {
-                    char client_fifo[256];
-                    size_t line_len = i - start;
-                    if (line_len >= sizeof(client_fifo)) line_len = sizeof(client_fifo) - 1;
-                    memcpy(client_fifo, accum + start, line_len);
-                    client_fifo[line_len] = '\0';
-                    start = i + 1;
-
-                    if (client_fifo[0] == '\0') continue;
-
-                    pthread_mutex_lock(&game_state->game_mutex);
-                    int already_started = game_state->game_started;
-                    pthread_mutex_unlock(&game_state->game_mutex);
-
-                    if (already_started) {
-                        printf("[CONNECTION] Rejected - game already started\n");
-                        reject_client(client_fifo,
-                                      "Server: Game already started. Please wait for the next lobby.\n");
-                        continue;
-                    }
-
-                    printf("[CONNECTION] New connection request\n");
-
-                    pthread_mutex_lock(&game_state->game_mutex);
-                    int player_id = -1;
-                    for (int p = 0; p < MAX_PLAYERS; p++) {
-                        if (!game_state->player_connected[p]) {
-                            player_id = p;
-                            game_state->player_connected[p] = 1;
-                            game_state->active_players++;
-                            if (game_state->host_player_id < 0) game_state->host_player_id = p;
-                            break;
-                        }
-                    }
-                    int connected_now = game_state->active_players;
-                    pthread_mutex_unlock(&game_state->game_mutex);
-
-                    if (player_id == -1) {
-                        printf("[CONNECTION] Rejected - server full\n");
-                        reject_client(client_fifo,
-                                      "Server: Full (max players reached). Try again later.\n");
-                        continue;
-                    }
-
-                    printf("[CONNECTION] Player %d assigned (%d/%d connected)\n",
-                           player_id + 1, connected_now, MAX_PLAYERS);
-
-                    pid_t pid = fork();
-                    if (pid < 0) {
-                        perror("fork failed");
-                        pthread_mutex_lock(&game_state->game_mutex);
-                        game_state->player_connected[player_id] = 0;
-                        game_state->active_players--;
-                        pthread_mutex_unlock(&game_state->game_mutex);
-                        reject_client(client_fifo, "Server: internal error (fork failed)\n");
-                    } else if (pid == 0) {
-                        handle_client(player_id, client_fifo);
-                        exit(0);
-                    } else {
-                        pthread_mutex_lock(&game_state->game_mutex);
-                        game_state->child_pid[player_id] = pid;
-                        pthread_mutex_unlock(&game_state->game_mutex);
-
-                        printf("[FORK] Created child process PID %d for Player %d\n",
-                               pid, player_id + 1);
-                    }
-
-                }
-            }
-
-            if (start > 0) {
-                memmove(accum, accum + start, accum_len - start);
-                accum_len -= start;
-            }
-        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-            perror("read server FIFO");
-        }
-
-        // Start game when host has chosen target and enough players are connected
-        pthread_mutex_lock(&game_state->game_mutex);
-        int target = game_state->target_players;
-        int connected = game_state->active_players;
-
-        if (!scheduler_created && !game_state->game_started && target > 0 && connected >= target) {
-            game_state->participants_count = 0;
-            for (int p = 0; p < MAX_PLAYERS; p++) {
-                if (game_state->player_connected[p] && game_state->participants_count < target) {
-                    game_state->participants[p] = 1;
-                    game_state->participants_count++;
-                } else {
-                    game_state->participants[p] = 0;
-                }
-                game_state->player_done[p] = 0;
-                game_state->final_scores[p] = 0;
-            }
-            game_state->winner_id = -1;
-
-            game_state->game_started = 1;
-            pthread_mutex_unlock(&game_state->game_mutex);
-
-            pthread_create(&scheduler_tid, NULL, scheduler_thread, NULL);
-            scheduler_created = 1;
-
-            printf("\n*** GAME STARTING with %d players! ***\n\n", target);
-        } else {
-            pthread_mutex_unlock(&game_state->game_mutex);
+        struct epoll_event events[8];
+        int ne = epoll_wait(ep_fd, events, 8, -1);
+        if (ne < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
         }
 
-        // If a game finished, scheduler will stop
-        if (scheduler_created && !reset_pending) {
-            pthread_mutex_lock(&game_state->game_mutex);
-            int finished = game_state->game_finished;
-            pthread_mutex_unlock(&game_state->game_mutex);
-
-            if (finished) {
-                pthread_join(scheduler_tid, NULL);
-                scheduler_created = 0;
-                reset_pending = 1;
+        for (int e = 0; e < ne; e++) {
+            int fd = events[e].data.fd;
+
+            if (fd == server_fd) {
+                read_connection_requests(server_fd, ctl, accum, sizeof(accum), &accum_len);
+            } else if (fd == notify_fd) {
+                uint64_t cnt;
+                while (read(notify_fd, &cnt, sizeof(cnt)) > 0) {}
+            } else if (fd == sig_fd) {
+                struct signalfd_siginfo si;
+                while (read(sig_fd, &si, sizeof(si)) > 0) {}
+                reap_children();
+            } else {
+                waiting_room_hangup(fd);
             }
         }
 
-        if (reset_pending) {
-            pthread_mutex_lock(&game_state->game_mutex);
-            int ap = game_state->active_players;
-            pthread_mutex_unlock(&game_state->game_mutex);
-
-            if (ap == 0) {
-                pthread_mutex_lock(&game_state->game_mutex);
-                reset_lobby_state_nolock();
-                pthread_mutex_unlock(&game_state->game_mutex);
-
-                reset_pending = 0;
-                printf("\n[SERVER] Lobby reset. Waiting for new players...\n");
-            }
+        for (int l = 0; l < num_lobbies; l++) {
+            service_lobby(l, &ctl[l]);
         }
-
-        struct timespec ts = {0, 100000000};
-        nanosleep(&ts, NULL);
+        admit_waiting(ctl);
     }
 
+    close(ep_fd);
+    free(ctl);
     close(server_fd);
-    munmap(game_state, sizeof(GameState));
+    store_close(score_store);
+    ckpt_close(checkpoint);
+    solver_unmap(&strategy);
+    munmap(arena, arena_size);
     shm_unlink("/yahtzee_shm");
+    shm_unlink(SNAPSHOT_SHM_NAME);
     return 0;
 }
@@ -0,0 +1,88 @@
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "snapshot.h"
+
+SnapshotArena* snapshot_create(int num_lobbies) {
+    size_t size = sizeof(SnapshotArena) + (size_t)num_lobbies * sizeof(LobbySnapshot);
+
+    shm_unlink(SNAPSHOT_SHM_NAME);
+    int fd = shm_open(SNAPSHOT_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return NULL;
+
+    if (ftruncate(fd, (off_t)size) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    SnapshotArena *snap = (SnapshotArena*) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED, fd, 0);
+    close(fd);
+    if (snap == MAP_FAILED) return NULL;
+
+    memset(snap, 0, size);
+    snap->num_lobbies = num_lobbies;
+    for (int l = 0; l < num_lobbies; l++) {
+        snap->lobbies[l].match.turn_owner = -1;
+        snap->lobbies[l].match.winner_id = -1;
+    }
+    atomic_thread_fence(memory_order_release);
+    snap->magic = SNAPSHOT_MAGIC;
+    return snap;
+}
+
+const SnapshotArena* snapshot_attach(size_t *size_out) {
+    int fd = shm_open(SNAPSHOT_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(SnapshotArena)) {
+        close(fd);
+        return NULL;
+    }
+
+    const SnapshotArena *snap = (const SnapshotArena*) mmap(NULL, (size_t)st.st_size, PROT_READ,
+                                                            MAP_SHARED, fd, 0);
+    close(fd);
+    if (snap == MAP_FAILED) return NULL;
+
+    size_t need = sizeof(SnapshotArena) + (size_t)snap->num_lobbies * sizeof(LobbySnapshot);
+    if (snap->magic != SNAPSHOT_MAGIC || need > (size_t)st.st_size) {
+        munmap((void*)snap, (size_t)st.st_size);
+        return NULL;
+    }
+
+    *size_out = (size_t)st.st_size;
+    return snap;
+}
+
+void seqlock_write_begin(_Atomic uint32_t *seq) {
+    uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void seqlock_write_end(_Atomic uint32_t *seq) {
+    uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_release);
+}
+
+uint32_t seqlock_read(const _Atomic uint32_t *seq, void *dst, const void *src, size_t len) {
+    while (1) {
+        uint32_t s1 = atomic_load_explicit((_Atomic uint32_t*)seq, memory_order_acquire);
+        if (s1 & 1) {
+            sched_yield();      // writer in progress
+            continue;
+        }
+
+        memcpy(dst, src, len);
+        atomic_thread_fence(memory_order_acquire);
+
+        uint32_t s2 = atomic_load_explicit((_Atomic uint32_t*)seq, memory_order_relaxed);
+        if (s1 == s2) return s1 >> 1;
+    }
+}
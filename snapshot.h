@@ -0,0 +1,94 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only game snapshots for spectators and monitoring tools.
+// The server republishes each lobby into a separate shared-memory object
+// after every state change. Each section is guarded by a seqlock: writers
+// (already serialized by the lock that owns the data) bump the sequence to
+// odd, copy, and bump it back to even; readers copy and retry if the
+// sequence moved. Readers map the object PROT_READ and never take a lock,
+// so any number of them can watch without slowing the game down.
+
+#define SNAPSHOT_SHM_NAME "/yahtzee_snap"
+#define SNAPSHOT_MAGIC    0x59534e50u      // "YSNP"
+#define SNAP_MAX_PLAYERS  5
+#define SNAP_NAME_SIZE    50
+#define SNAP_LEADERS      10
+
+typedef struct {
+    int connected;
+    int participant;
+    int done;
+    int final_score;
+    char name[SNAP_NAME_SIZE];
+} SnapSeat;
+
+// Match-level view, written under the lobby's match_mutex
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    int game_started;
+    int game_finished;
+    int target_players;
+    int active_players;
+    int turn_owner;                        // -1 when no turn is running
+    int winner_id;
+    SnapSeat seats[SNAP_MAX_PLAYERS];
+} SnapMatch;
+
+// One player's dice and scorecard, written under that player's lock
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    int dice[5];
+    int rerolls_left;
+    int score[15];                         // 13 categories, upper bonus, Yahtzee bonus
+    unsigned char scored[15];
+    int total;
+} SnapPlayer;
+
+typedef struct {
+    SnapMatch match;
+    SnapPlayer players[SNAP_MAX_PLAYERS];
+} LobbySnapshot;
+
+typedef struct {
+    char name[SNAP_NAME_SIZE];
+    uint32_t wins;
+    uint32_t games;
+    uint32_t high_score;
+    uint64_t total_score;
+} SnapLeader;
+
+// Top of the persistent leaderboard, republished after every finished game
+// under the server's leaders_mutex
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    uint32_t players;                      // everyone on file
+    int count;
+    SnapLeader top[SNAP_LEADERS];
+} SnapLeaders;
+
+typedef struct {
+    uint32_t magic;
+    int num_lobbies;
+    SnapLeaders leaders;
+    LobbySnapshot lobbies[];
+} SnapshotArena;
+
+// Server: create (or recreate) the snapshot object for `num_lobbies` lobbies.
+SnapshotArena* snapshot_create(int num_lobbies);
+
+// Readers: map an existing snapshot object read-only. NULL if the server is not up.
+const SnapshotArena* snapshot_attach(size_t *size_out);
+
+void seqlock_write_begin(_Atomic uint32_t *seq);
+void seqlock_write_end(_Atomic uint32_t *seq);
+
+// Copy `len` bytes at `src` (guarded by `seq`) into `dst` without tearing.
+// Returns the version of the copy (number of completed publishes).
+uint32_t seqlock_read(const _Atomic uint32_t *seq, void *dst, const void *src, size_t len);
+
+#endif
@@ -0,0 +1,379 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "reroll.h"
+#include "solver.h"
+
+static unsigned char upper_reach[64][SOLVER_UPPER_CAP + 1];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void build_tables(void) {
+    reroll_init();
+
+    // Upper subtotals each set of filled upper boxes can produce (capped)
+    for (int m = 0; m < 64; m++) {
+        unsigned char cur[SOLVER_UPPER_CAP + 1] = {0};
+        cur[0] = 1;
+        for (int face = 1; face <= 6; face++) {
+            if (!(m & (1 << (face - 1)))) continue;
+            unsigned char next[SOLVER_UPPER_CAP + 1] = {0};
+            for (int u = 0; u <= SOLVER_UPPER_CAP; u++) {
+                if (!cur[u]) continue;
+                for (int c = 0; c <= 5; c++) {
+                    int v = u + c * face;
+                    next[v > SOLVER_UPPER_CAP ? SOLVER_UPPER_CAP : v] = 1;
+                }
+            }
+            memcpy(cur, next, sizeof(cur));
+        }
+        memcpy(upper_reach[m], cur, sizeof(cur));
+    }
+}
+
+static void solver_init(void) {
+    pthread_once(&tables_once, build_tables);
+}
+
+int solver_state_reachable(int used, int upper, int yahtzee) {
+    solver_init();
+    if (yahtzee && !(used & (1 << CAT_YAHTZEE))) return 0;
+    return upper_reach[used & 63][upper];
+}
+
+// Every choice the rules allow for a final roll. Mirrors
+// session_apply_yahtzee_rules_plocked: with Yahtzee already scored as 50,
+// another Yahtzee earns 100 and must fill its own upper box if that is
+// open, else any open lower box (Joker scores), else any open box.
+static int score_choices(const float *values, int used, int upper, int yahtzee, int r,
+                         SolverChoice out[SCORING_NUM_CATEGORIES]) {
+    int scores[SCORING_NUM_CATEGORIES];
+    scoring_possible_scores(r, yahtzee, scores);
+
+    int is_yahtzee = scores[CAT_YAHTZEE] == 50;
+    int extra = (is_yahtzee && yahtzee) ? 100 : 0;
+    int first = 0, last = SCORING_NUM_CATEGORIES - 1;
+
+    if (is_yahtzee && yahtzee) {
+        int req = scoring_roll_dice(r)[0] - 1;
+        int lower_open = (used & 0x1fc0) != 0x1fc0;
+        if (!(used & (1 << req))) {
+            first = last = req;
+        } else if (lower_open) {
+            first = CAT_THREE_KIND;
+        }
+    }
+
+    int n = 0;
+    for (int c = first; c <= last; c++) {
+        if (used & (1 << c)) continue;
+
+        int pts = scores[c] + extra;
+        int nu = upper, ny = yahtzee;
+        if (c < 6) {
+            nu = upper + scores[c];
+            if (nu >= SOLVER_UPPER_CAP) {
+                if (upper < SOLVER_UPPER_CAP) pts += 35;
+                nu = SOLVER_UPPER_CAP;
+            }
+        }
+        if (c == CAT_YAHTZEE && scores[c] == 50) ny = 1;
+
+        int nused = used | (1 << c);
+        double future = nused == SOLVER_ALL_USED ? 0.0
+                      : values[solver_state_index(nused, nu, ny)];
+
+        out[n].category = c;
+        out[n].points = pts;
+        out[n].value = pts + future;
+        n++;
+    }
+    return n;
+}
+
+static double best_choice(const float *values, int used, int upper, int yahtzee, int r) {
+    SolverChoice ch[SCORING_NUM_CATEGORIES];
+    int n = score_choices(values, used, upper, yahtzee, r, ch);
+    double best = ch[0].value;
+    for (int i = 1; i < n; i++) if (ch[i].value > best) best = ch[i].value;
+    return best;
+}
+
+// Best hold for every roll, given what each keep is worth
+static void best_holds(const double keep_ev[REROLL_NUM_KEEPS], double roll_ev[SCORING_NUM_ROLLS]) {
+    for (int r = 0; r < SCORING_NUM_ROLLS; r++) {
+        int n;
+        const short *keeps = reroll_roll_keeps(r, &n);
+        double best = keep_ev[keeps[0]];
+        for (int j = 1; j < n; j++) {
+            if (keep_ev[keeps[j]] > best) best = keep_ev[keeps[j]];
+        }
+        roll_ev[r] = best;
+    }
+}
+
+float solver_eval_state(const float *values, int used, int upper, int yahtzee) {
+    solver_init();
+
+    double ev[SCORING_NUM_ROLLS], keep_ev[REROLL_NUM_KEEPS];
+    for (int r = 0; r < SCORING_NUM_ROLLS; r++) ev[r] = best_choice(values, used, upper, yahtzee, r);
+
+    // Two rerolls: each pass folds one more roll into ev
+    for (int pass = 0; pass < 2; pass++) {
+        reroll_expect_all(ev, keep_ev);
+        best_holds(keep_ev, ev);
+    }
+
+    // The first roll is five fresh dice
+    return (float)reroll_expect(REROLL_KEEP_NONE, ev);
+}
+
+// One used-mask: every reachable (upper, yahtzee) combination under it
+static void build_mask(float *values, int used) {
+    for (int upper = 0; upper <= SOLVER_UPPER_CAP; upper++) {
+        for (int y = 0; y <= 1; y++) {
+            if (!solver_state_reachable(used, upper, y)) continue;
+            values[solver_state_index(used, upper, y)] = solver_eval_state(values, used, upper, y);
+        }
+    }
+}
+
+// Parallel build. A state only depends on states with one more category
+// filled, so the levels run in order (13 filled down to 0) with a barrier
+// between them, and every used-mask within a level is an independent task.
+//
+// Work stealing: each level's tasks are dealt out as one contiguous range
+// per worker. A worker pops from the front of its own range; when that is
+// empty it steals the back half of another worker's range. Both ends of a
+// range are packed in one 64-bit word, so popping and stealing are each a
+// single CAS and no worker ever waits on a lock inside a level.
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;   // begin << 32 | end
+} WorkRange;
+
+typedef struct {
+    float *values;
+    int threads;
+    int tasks[SOLVER_NUM_MASKS];           // used-masks of the current level
+    WorkRange *ranges;
+    pthread_barrier_t barrier;
+    _Atomic long steals;
+} BuildPool;
+
+typedef struct {
+    BuildPool *pool;
+    int id;
+} BuildWorker;
+
+static uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return (uint64_t)begin << 32 | end;
+}
+
+static int pop_own(WorkRange *r) {
+    uint64_t x = atomic_load(&r->range);
+    while (1) {
+        uint32_t begin = (uint32_t)(x >> 32), end = (uint32_t)x;
+        if (begin >= end) return -1;
+        if (atomic_compare_exchange_weak(&r->range, &x, pack_range(begin + 1, end))) return (int)begin;
+    }
+}
+
+// Move the back half of victim's range into our (empty) range
+static int steal_half(WorkRange *victim, WorkRange *mine) {
+    uint64_t x = atomic_load(&victim->range);
+    while (1) {
+        uint32_t begin = (uint32_t)(x >> 32), end = (uint32_t)x;
+        if (begin >= end) return 0;
+        uint32_t half = (end - begin + 1) / 2;
+        if (atomic_compare_exchange_weak(&victim->range, &x, pack_range(begin, end - half))) {
+            atomic_store(&mine->range, pack_range(end - half, end));
+            return 1;
+        }
+    }
+}
+
+static void run_level(BuildPool *pool, int id) {
+    WorkRange *mine = &pool->ranges[id];
+    while (1) {
+        int t = pop_own(mine);
+        if (t >= 0) {
+            build_mask(pool->values, pool->tasks[t]);
+            continue;
+        }
+
+        int stolen = 0;
+        for (int k = 1; k < pool->threads && !stolen; k++) {
+            stolen = steal_half(&pool->ranges[(id + k) % pool->threads], mine);
+        }
+        if (!stolen) return;               // nothing left anywhere in this level
+        atomic_fetch_add(&pool->steals, 1);
+    }
+}
+
+static void *build_worker(void *arg) {
+    BuildWorker *w = (BuildWorker*)arg;
+    BuildPool *pool = w->pool;
+
+    for (int filled = SCORING_NUM_CATEGORIES - 1; filled >= 0; filled--) {
+        if (w->id == 0) {
+            int n = 0;
+            for (int used = 0; used < SOLVER_NUM_MASKS; used++) {
+                if (__builtin_popcount(used) == filled) pool->tasks[n++] = used;
+            }
+            for (int i = 0; i < pool->threads; i++) {
+                uint32_t begin = (uint32_t)((long)n * i / pool->threads);
+                uint32_t end = (uint32_t)((long)n * (i + 1) / pool->threads);
+                atomic_store(&pool->ranges[i].range, pack_range(begin, end));
+            }
+        }
+        pthread_barrier_wait(&pool->barrier);
+        run_level(pool, w->id);
+        pthread_barrier_wait(&pool->barrier);
+    }
+    return NULL;
+}
+
+long solver_build(float *values, int threads) {
+    solver_init();
+    memset(values, 0, sizeof(float) * SOLVER_NUM_STATES);
+    if (threads < 1) threads = 1;
+
+    BuildPool *pool = (BuildPool*)calloc(1, sizeof(BuildPool));
+    WorkRange *ranges = (WorkRange*)aligned_alloc(64, sizeof(WorkRange) * (size_t)threads);
+    BuildWorker *workers = (BuildWorker*)calloc((size_t)threads, sizeof(BuildWorker));
+    pthread_t *tids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool || !ranges || !workers || !tids) {
+        free(pool); free(ranges); free(workers); free(tids);
+        return -1;
+    }
+
+    pool->values = values;
+    pool->threads = threads;
+    pool->ranges = ranges;
+    pthread_barrier_init(&pool->barrier, NULL, (unsigned)threads);
+
+    // The calling thread is worker 0
+    for (int i = 0; i < threads; i++) {
+        workers[i].pool = pool;
+        workers[i].id = i;
+        if (i > 0) pthread_create(&tids[i], NULL, build_worker, &workers[i]);
+    }
+    build_worker(&workers[0]);
+    for (int i = 1; i < threads; i++) pthread_join(tids[i], NULL);
+
+    long steals = atomic_load(&pool->steals);
+    pthread_barrier_destroy(&pool->barrier);
+    free(pool); free(ranges); free(workers); free(tids);
+    return steals;
+}
+
+int solver_write(const char *path, const float *values) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    StrategyHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SOLVER_MAGIC;
+    hdr.version = SOLVER_VERSION;
+    hdr.num_states = SOLVER_NUM_STATES;
+    hdr.start_value = values[solver_state_index(0, 0, 0)];
+
+    size_t body = sizeof(float) * SOLVER_NUM_STATES;
+    int ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+             write(fd, values, body) == (ssize_t)body &&
+             fsync(fd) == 0;
+    close(fd);
+
+    // Readers never see a half-written table
+    if (!ok || rename(tmp, path) == -1) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int solver_map(const char *path, StrategyTable *t) {
+    memset(t, 0, sizeof(*t));
+    solver_init();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    size_t want = sizeof(StrategyHeader) + sizeof(float) * SOLVER_NUM_STATES;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size != want) {
+        close(fd);
+        return -1;
+    }
+
+    void *p = mmap(NULL, want, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+
+    const StrategyHeader *hdr = (const StrategyHeader*)p;
+    if (hdr->magic != SOLVER_MAGIC || hdr->version != SOLVER_VERSION ||
+        hdr->num_states != SOLVER_NUM_STATES) {
+        munmap(p, want);
+        return -1;
+    }
+
+    t->hdr = hdr;
+    t->values = (const float*)(hdr + 1);
+    t->size = want;
+    return 0;
+}
+
+void solver_unmap(StrategyTable *t) {
+    if (t->hdr) munmap((void*)t->hdr, t->size);
+    memset(t, 0, sizeof(*t));
+}
+
+int solver_score_options(const StrategyTable *t, const SolverState *s, int roll_index,
+                         SolverChoice out[SCORING_NUM_CATEGORIES]) {
+    return score_choices(t->values, s->used, s->upper, s->yahtzee, roll_index, out);
+}
+
+void solver_turn(const StrategyTable *t, const SolverState *s, SolverTurn *out) {
+    double ev[SCORING_NUM_ROLLS], keep_ev[REROLL_NUM_KEEPS];
+    for (int r = 0; r < SCORING_NUM_ROLLS; r++) {
+        ev[r] = best_choice(t->values, s->used, s->upper, s->yahtzee, r);
+        out->stand[r] = (float)ev[r];
+    }
+
+    // keep[0]: the last reroll; keep[1]: with one more to come after it
+    for (int pass = 0; pass < 2; pass++) {
+        reroll_expect_all(ev, keep_ev);
+        for (int k = 0; k < REROLL_NUM_KEEPS; k++) out->keep[pass][k] = (float)keep_ev[k];
+        if (pass == 0) best_holds(keep_ev, ev);
+    }
+}
+
+int solver_turn_holds(const SolverTurn *turn, const int dice[5], int rerolls_left, double out[32]) {
+    const float *keep = turn->keep[rerolls_left >= 2 ? 1 : 0];
+
+    // Standing pat wins ties: no point rerolling for nothing
+    int best = REROLL_HOLD_ALL;
+    out[REROLL_HOLD_ALL] = turn->stand[scoring_roll_index(dice)];
+    for (int mask = 0; mask < REROLL_HOLD_ALL; mask++) {
+        out[mask] = keep[reroll_keep_of_dice(dice, mask)];
+        if (out[mask] > out[best] + 1e-4) best = mask;
+    }
+    return best;
+}
+
+int solver_hold_values(const StrategyTable *t, const SolverState *s, const int dice[5],
+                       int rerolls_left, double out[32]) {
+    SolverTurn turn;
+    solver_turn(t, s, &turn);
+    return solver_turn_holds(&turn, dice, rerolls_left, out);
+}
@@ -0,0 +1,116 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "reroll.h"
+#include "scoring.h"
+
+// Expected-value-optimal solitaire strategy for this server's rules.
+//
+// Between turns a player's future only depends on which categories are
+// used (13-bit mask), the upper-section subtotal capped at 63 (the bonus
+// threshold) and whether Yahtzee was scored as 50 (which turns on the
+// Yahtzee bonus and the Joker rules). For every such state the table holds
+// the expected number of points still to come with optimal play, upper
+// bonus and Yahtzee bonuses included. The turn rules mirror the server:
+// calculate_possible_scores for category scores and
+// session_apply_yahtzee_rules_plocked for extra Yahtzees (the +100 bonus,
+// the forced upper-section fill, and the lower-section-only choice).
+//
+// The table is built offline by strategy_gen and written as a flat file
+// that the server maps read-only at startup. Decisions then combine table
+// lookups with one turn's worth of arithmetic, a few microseconds.
+
+#define SOLVER_MAGIC       0x59535452u     // "YSTR"
+#define SOLVER_VERSION     1
+#define SOLVER_UPPER_CAP   63
+#define SOLVER_NUM_MASKS   (1 << SCORING_NUM_CATEGORIES)
+#define SOLVER_NUM_STATES  (SOLVER_NUM_MASKS * 64 * 2)
+#define SOLVER_ALL_USED    (SOLVER_NUM_MASKS - 1)
+#define SOLVER_FILE        "strategy.bin"
+
+typedef struct {
+    uint16_t used;                         // bit c set when category c is filled
+    uint8_t upper;                         // upper-section points, capped at 63
+    uint8_t yahtzee;                       // Yahtzee scored as 50
+} SolverState;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_states;
+    float start_value;                     // expected score of a whole game
+    uint32_t reserved[4];
+} StrategyHeader;
+
+typedef struct {
+    const StrategyHeader *hdr;
+    const float *values;                   // indexed by solver_state_index
+    size_t size;                           // bytes mapped
+} StrategyTable;
+
+typedef struct {
+    int category;
+    int points;                            // points this choice scores now (bonuses included)
+    double value;                          // points now + expected points still to come
+} SolverChoice;
+
+// Everything a hold decision needs for one state, whatever the dice: the
+// value of scoring each roll now and of each keep with 1 or 2 rerolls left
+typedef struct {
+    float stand[SCORING_NUM_ROLLS];
+    float keep[2][REROLL_NUM_KEEPS];
+} SolverTurn;
+
+// Building (strategy_gen)
+
+// Is this state possible in a real game? Unreachable states keep value 0.
+int solver_state_reachable(int used, int upper, int yahtzee);
+
+// Expected future points of one reachable, unfinished state. Every state
+// with one more category used must already be in `values`.
+float solver_eval_state(const float *values, int used, int upper, int yahtzee);
+
+// Fill `values` (SOLVER_NUM_STATES floats) one filled-count level at a time,
+// spreading each level over `threads` work-stealing workers (1 = run on the
+// calling thread only). The result does not depend on the thread count.
+// Returns the number of steals, or -1 on allocation failure.
+long solver_build(float *values, int threads);
+
+// Write values with a header to `path`. Returns 0 or -1.
+int solver_write(const char *path, const float *values);
+
+// Using a table
+
+// Map a table file read-only. Returns 0, or -1 if it is missing or invalid.
+int solver_map(const char *path, StrategyTable *t);
+void solver_unmap(StrategyTable *t);
+
+static inline uint32_t solver_state_index(int used, int upper, int yahtzee) {
+    return ((uint32_t)used << 7) | ((uint32_t)upper << 1) | (uint32_t)(yahtzee != 0);
+}
+
+static inline float solver_state_value(const StrategyTable *t, const SolverState *s) {
+    return t->values[solver_state_index(s->used, s->upper, s->yahtzee)];
+}
+
+// Categories the rules allow for a final roll, each with its value.
+// Returns the count (1 when the Joker rule forces an upper box).
+int solver_score_options(const StrategyTable *t, const SolverState *s, int roll_index,
+                         SolverChoice out[SCORING_NUM_CATEGORIES]);
+
+// One turn's worth of arithmetic for state `s` (tens of microseconds).
+void solver_turn(const StrategyTable *t, const SolverState *s, SolverTurn *out);
+
+// Value of keeping each subset of `dice` (bit i = keep dice[i]) with
+// `rerolls_left` (1 or 2) rerolls to go. out[31] is standing pat.
+// Returns the best mask. Pure lookups once the turn is evaluated.
+int solver_turn_holds(const SolverTurn *turn, const int dice[5], int rerolls_left, double out[32]);
+
+// solver_turn followed by solver_turn_holds
+int solver_hold_values(const StrategyTable *t, const SolverState *s, const int dice[5],
+                       int rerolls_left, double out[32]);
+
+#endif
@@ -0,0 +1,528 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "store.h"
+
+// Record layout before the leaderboard links were added
+typedef struct {
+    uint32_t hash;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t high_score;
+    uint64_t total_score;
+    char name[STORE_NAME_SIZE];
+} StoreRecordV1;
+
+static size_t table_bytes(uint32_t capacity) {
+    return (size_t)capacity * sizeof(StoreRecord);
+}
+
+// FNV-1a; 0 is reserved for empty slots
+static uint32_t name_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)name; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static int map_table(Store *st, uint32_t capacity) {
+    if (st->records) munmap(st->records, table_bytes(st->capacity));
+    st->records = NULL;
+
+    void *p = mmap(NULL, table_bytes(capacity), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, st->fd, STORE_HEADER_SIZE);
+    if (p == MAP_FAILED) return -1;
+    st->records = (StoreRecord*)p;
+    st->capacity = capacity;
+    return 0;
+}
+
+static void board_rebuild(Store *st);
+
+// Take the store lock and make sure our table mapping matches the file
+static int store_lock(Store *st) {
+    int rc = pthread_mutex_lock(&st->hdr->lock);
+    if (rc != 0 && rc != EOWNERDEAD) return -1;
+
+    if (st->hdr->capacity != st->capacity && map_table(st, st->hdr->capacity) < 0) {
+        pthread_mutex_unlock(&st->hdr->lock);
+        return -1;
+    }
+
+    if (rc == EOWNERDEAD) {
+        // A writer died holding the lock. Its record's counters are at worst
+        // one game behind, but it may have been halfway through relinking
+        // the leaderboard, so rebuild the tree from the records before
+        // anyone walks it again.
+        board_rebuild(st);
+        pthread_mutex_consistent(&st->hdr->lock);
+    }
+    return 0;
+}
+
+static void store_unlock(Store *st) {
+    pthread_mutex_unlock(&st->hdr->lock);
+}
+
+// Slot holding `name`, or the empty slot where it would go
+static StoreRecord *probe(StoreRecord *records, uint32_t capacity, const char *name, uint32_t h) {
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = h & mask;; i = (i + 1) & mask) {
+        StoreRecord *r = &records[i];
+        if (r->hash == 0) return r;
+        if (r->hash == h && strncmp(r->name, name, STORE_NAME_SIZE) == 0) return r;
+    }
+}
+
+// Leaderboard treap. Nodes are named by slot + 1 so that 0 can mean "none";
+// every function here runs with the lock held.
+
+static StoreRecord *node(Store *st, uint32_t id) {
+    return &st->records[id - 1];
+}
+
+static uint32_t node_id(Store *st, const StoreRecord *r) {
+    return (uint32_t)(r - st->records) + 1;
+}
+
+static uint32_t subtree_size(Store *st, uint32_t id) {
+    return id ? node(st, id)->size : 0;
+}
+
+static void fix_size(Store *st, uint32_t id) {
+    StoreRecord *n = node(st, id);
+    n->size = 1 + subtree_size(st, n->left) + subtree_size(st, n->right);
+}
+
+// Heap priority: the name hash run through a mixer, independent of rank
+static uint32_t priority(const StoreRecord *r) {
+    uint32_t h = r->hash;
+    h ^= h >> 16; h *= 0x85ebca6bu;
+    h ^= h >> 13; h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Does `a` rank ahead of `b`? Averages are compared by cross-multiplying.
+static int ranks_ahead(const StoreRecord *a, const StoreRecord *b) {
+    if (a->wins != b->wins) return a->wins > b->wins;
+
+    uint64_t avg_a = a->total_score * (b->games ? b->games : 1);
+    uint64_t avg_b = b->total_score * (a->games ? a->games : 1);
+    if (avg_a != avg_b) return avg_a > avg_b;
+
+    if (a->high_score != b->high_score) return a->high_score > b->high_score;
+    return strncmp(a->name, b->name, STORE_NAME_SIZE) < 0;
+}
+
+// Split subtree `t` into the nodes ranking ahead of `key` and the rest
+static void split(Store *st, uint32_t t, const StoreRecord *key, uint32_t *ahead, uint32_t *behind) {
+    if (!t) {
+        *ahead = *behind = 0;
+        return;
+    }
+    StoreRecord *n = node(st, t);
+    if (ranks_ahead(n, key)) {
+        split(st, n->right, key, &n->right, behind);
+        *ahead = t;
+    } else {
+        split(st, n->left, key, ahead, &n->left);
+        *behind = t;
+    }
+    fix_size(st, t);
+}
+
+// Join two subtrees where everything in `a` ranks ahead of everything in `b`
+static uint32_t merge(Store *st, uint32_t a, uint32_t b) {
+    if (!a) return b;
+    if (!b) return a;
+    StoreRecord *na = node(st, a), *nb = node(st, b);
+    if (priority(na) > priority(nb)) {
+        na->right = merge(st, na->right, b);
+        fix_size(st, a);
+        return a;
+    }
+    nb->left = merge(st, a, nb->left);
+    fix_size(st, b);
+    return b;
+}
+
+static void board_link(Store *st, StoreRecord *r) {
+    uint32_t ahead, behind;
+    if (st->bulk) return;                  // store_import_end links everything
+    r->left = r->right = 0;
+    r->size = 1;
+    split(st, st->hdr->root, r, &ahead, &behind);
+    st->hdr->root = merge(st, merge(st, ahead, node_id(st, r)), behind);
+}
+
+static uint32_t erase(Store *st, uint32_t t, const StoreRecord *r) {
+    if (!t) return 0;
+    StoreRecord *n = node(st, t);
+    if (n == r) return merge(st, n->left, n->right);
+    if (ranks_ahead(r, n)) n->left = erase(st, n->left, r);
+    else                   n->right = erase(st, n->right, r);
+    fix_size(st, t);
+    return t;
+}
+
+// Must run before the stats that order `r` change
+static void board_unlink(Store *st, StoreRecord *r) {
+    if (!r->size) return;                  // not linked yet
+    st->hdr->root = erase(st, st->hdr->root, r);
+    r->left = r->right = 0;
+    r->size = 0;
+}
+
+static int rank_order(const void *a, const void *b) {
+    const StoreRecord *ra = *(StoreRecord *const*)a, *rb = *(StoreRecord *const*)b;
+    return ranks_ahead(ra, rb) ? -1 : ranks_ahead(rb, ra) ? 1 : 0;
+}
+
+// Relink every record. Sorting by rank and building the treap bottom-up
+// along its right spine costs one sort instead of n split/merge walks.
+static void board_rebuild(Store *st) {
+    uint32_t n = 0;
+    StoreRecord **sorted = (StoreRecord**)malloc((size_t)st->hdr->count * sizeof(StoreRecord*));
+    uint32_t *spine = (uint32_t*)malloc((size_t)st->hdr->count * sizeof(uint32_t));
+    st->hdr->root = 0;
+
+    if (!sorted || !spine) {
+        // Out of memory: fall back to linking one at a time
+        free(sorted);
+        free(spine);
+        for (uint32_t i = 0; i < st->capacity; i++) {
+            if (st->records[i].hash) board_link(st, &st->records[i]);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < st->capacity && n < st->hdr->count; i++) {
+        if (st->records[i].hash) sorted[n++] = &st->records[i];
+    }
+    qsort(sorted, n, sizeof(*sorted), rank_order);
+
+    // Each record pops the lower-priority tail of the spine as its left
+    // subtree and becomes the new tail. Popped subtrees are final.
+    uint32_t top = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        StoreRecord *r = sorted[i];
+        uint32_t id = node_id(st, r), left = 0;
+        while (top && priority(node(st, spine[top - 1])) < priority(r)) {
+            left = spine[--top];
+            fix_size(st, left);
+        }
+        r->left = left;
+        r->right = 0;
+        if (top) node(st, spine[top - 1])->right = id;
+        spine[top++] = id;
+    }
+    st->hdr->root = top ? spine[0] : 0;
+    while (top) fix_size(st, spine[--top]);
+    free(sorted);
+    free(spine);
+}
+
+static void collect_top(Store *st, uint32_t t, LeaderEntry *out, int k, int *n) {
+    if (!t || *n >= k) return;
+    StoreRecord *r = node(st, t);
+    collect_top(st, r->left, out, k, n);
+    if (*n >= k) return;
+
+    LeaderEntry *e = &out[(*n)++];
+    memcpy(e->name, r->name, STORE_NAME_SIZE);
+    e->stats.games = r->games;
+    e->stats.wins = r->wins;
+    e->stats.high_score = r->high_score;
+    e->stats.total_score = r->total_score;
+
+    collect_top(st, r->right, out, k, n);
+}
+
+
+// Double the table in place. Caller holds the lock.
+static int grow(Store *st) {
+    uint32_t old_cap = st->capacity;
+    uint32_t new_cap = old_cap * 2;
+
+    StoreRecord *live = (StoreRecord*)malloc((size_t)st->hdr->count * sizeof(StoreRecord));
+    if (!live) return -1;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < old_cap; i++) {
+        if (st->records[i].hash) live[n++] = st->records[i];
+    }
+
+    if (ftruncate(st->fd, (off_t)(STORE_HEADER_SIZE + table_bytes(new_cap))) == -1 ||
+        map_table(st, new_cap) < 0) {
+        // Keep serving from the old table if we can get it back
+        map_table(st, old_cap);
+        free(live);
+        return -1;
+    }
+
+    memset(st->records, 0, table_bytes(new_cap));
+    for (uint32_t i = 0; i < n; i++) {
+        *probe(st->records, new_cap, live[i].name, live[i].hash) = live[i];
+    }
+    st->hdr->capacity = new_cap;
+    free(live);
+
+    // Slots moved, so every link is stale
+    if (!st->bulk) board_rebuild(st);
+    return 0;
+}
+
+// Find or create the record for `name`. Caller holds the lock. A new record
+// is not on the leaderboard until the caller links it.
+static StoreRecord *upsert(Store *st, const char *name) {
+    char key[STORE_NAME_SIZE] = {0};
+    strncpy(key, name, STORE_NAME_SIZE - 1);
+    uint32_t h = name_hash(key);
+
+    StoreRecord *r = probe(st->records, st->capacity, key, h);
+    if (r->hash) return r;
+
+    // Keep probe runs short: never more than 3/4 full
+    if ((uint64_t)(st->hdr->count + 1) * 4 > (uint64_t)st->capacity * 3) {
+        if (grow(st) < 0) return NULL;
+        r = probe(st->records, st->capacity, key, h);
+    }
+
+    memset(r, 0, sizeof(*r));
+    memcpy(r->name, key, STORE_NAME_SIZE);
+    r->hash = h;
+    st->hdr->count++;
+    return r;
+}
+
+// Occupied records of a file written before the leaderboard existed
+static StoreRecordV1 *read_v1_records(int fd, uint32_t capacity, uint32_t *count) {
+    size_t bytes = (size_t)capacity * sizeof(StoreRecordV1);
+    StoreRecordV1 *recs = (StoreRecordV1*)malloc(bytes);
+    if (!recs) return NULL;
+    if (pread(fd, recs, bytes, STORE_HEADER_SIZE) != (ssize_t)bytes) {
+        free(recs);
+        return NULL;
+    }
+
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (recs[i].hash) {
+            recs[n] = recs[i];
+            recs[n].name[STORE_NAME_SIZE - 1] = '\0';
+            n++;
+        }
+    }
+    *count = n;
+    return recs;
+}
+
+static int init_file(Store *st) {
+    if (ftruncate(st->fd, 0) == -1 ||
+        ftruncate(st->fd, (off_t)(STORE_HEADER_SIZE + table_bytes(STORE_MIN_CAP))) == -1) {
+        return -1;
+    }
+    memset(st->hdr, 0, sizeof(StoreHeader));
+    st->hdr->capacity = STORE_MIN_CAP;
+    return 0;
+}
+
+Store* store_open(const char *path, int *created) {
+    Store *st = (Store*)calloc(1, sizeof(Store));
+    if (!st) return NULL;
+    *created = 0;
+
+    StoreRecordV1 *old = NULL;             // records of a pre-leaderboard file
+    uint32_t old_count = 0;
+
+    st->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (st->fd < 0) {
+        free(st);
+        return NULL;
+    }
+
+    struct stat sb;
+    if (fstat(st->fd, &sb) == -1) goto fail;
+    if ((size_t)sb.st_size < STORE_HEADER_SIZE &&
+        ftruncate(st->fd, STORE_HEADER_SIZE) == -1) goto fail;
+
+    void *p = mmap(NULL, STORE_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, st->fd, 0);
+    if (p == MAP_FAILED) goto fail;
+    st->hdr = (StoreHeader*)p;
+
+    // Anything that does not look like a whole table starts over empty
+    uint32_t cap = st->hdr->capacity;
+    int valid = cap >= STORE_MIN_CAP && !(cap & (cap - 1)) && st->hdr->count < cap;
+
+    if (valid && st->hdr->magic == STORE_MAGIC_V1 &&
+        (size_t)sb.st_size >= STORE_HEADER_SIZE + (size_t)cap * sizeof(StoreRecordV1)) {
+        old = read_v1_records(st->fd, cap, &old_count);
+        if (!old || init_file(st) < 0) goto fail;
+    } else if (!valid || st->hdr->magic != STORE_MAGIC ||
+               (size_t)sb.st_size < STORE_HEADER_SIZE + table_bytes(cap)) {
+        if (init_file(st) < 0) goto fail;
+        *created = 1;
+    }
+
+    // Whoever held the lock before is gone: we are the only opener
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&st->hdr->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if (map_table(st, st->hdr->capacity) < 0) goto fail;
+    st->hdr->magic = STORE_MAGIC;
+
+    if (old) {
+        for (uint32_t i = 0; i < old_count; i++) {
+            StoreRecord *r = upsert(st, old[i].name);
+            if (!r) break;
+            r->games = old[i].games;
+            r->wins = old[i].wins;
+            r->high_score = old[i].high_score;
+            r->total_score = old[i].total_score;
+        }
+        free(old);
+        board_rebuild(st);
+    }
+    return st;
+
+fail:
+    free(old);
+    if (st->hdr) munmap(st->hdr, STORE_HEADER_SIZE);
+    close(st->fd);
+    free(st);
+    return NULL;
+}
+
+void store_close(Store *st) {
+    if (!st) return;
+    if (st->records) {
+        msync(st->records, table_bytes(st->capacity), MS_SYNC);
+        munmap(st->records, table_bytes(st->capacity));
+    }
+    msync(st->hdr, STORE_HEADER_SIZE, MS_SYNC);
+    munmap(st->hdr, STORE_HEADER_SIZE);
+    close(st->fd);
+    free(st);
+}
+
+int store_lookup(Store *st, const char *name, PlayerStats *out) {
+    char key[STORE_NAME_SIZE] = {0};
+    strncpy(key, name, STORE_NAME_SIZE - 1);
+
+    if (store_lock(st) < 0) return 0;
+    StoreRecord *r = probe(st->records, st->capacity, key, name_hash(key));
+    int found = r->hash != 0;
+    if (found) {
+        out->games = r->games;
+        out->wins = r->wins;
+        out->high_score = r->high_score;
+        out->total_score = r->total_score;
+    }
+    store_unlock(st);
+    return found;
+}
+
+int store_record_game(Store *st, const char *name, int score, int won) {
+    if (store_lock(st) < 0) return -1;
+    StoreRecord *r = upsert(st, name);
+    if (r) {
+        board_unlink(st, r);
+        r->games++;
+        if (won) r->wins++;
+        if (score > 0 && (uint32_t)score > r->high_score) r->high_score = (uint32_t)score;
+        if (score > 0) r->total_score += (uint64_t)score;
+        board_link(st, r);
+    }
+    store_unlock(st);
+    return r ? 0 : -1;
+}
+
+int store_set_wins(Store *st, const char *name, uint32_t wins) {
+    if (store_lock(st) < 0) return -1;
+    StoreRecord *r = upsert(st, name);
+    if (r) {
+        board_unlink(st, r);
+        r->wins = wins;
+        board_link(st, r);
+    }
+    store_unlock(st);
+    return r ? 0 : -1;
+}
+
+void store_import_begin(Store *st) {
+    if (store_lock(st) < 0) return;
+    for (uint32_t i = 0; i < st->capacity; i++) {
+        st->records[i].left = st->records[i].right = st->records[i].size = 0;
+    }
+    st->hdr->root = 0;
+    st->bulk = 1;
+    store_unlock(st);
+}
+
+void store_import_end(Store *st) {
+    if (store_lock(st) < 0) return;
+    st->bulk = 0;
+    board_rebuild(st);
+    store_unlock(st);
+}
+
+uint32_t store_count(Store *st) {
+    if (store_lock(st) < 0) return 0;
+    uint32_t n = st->hdr->count;
+    store_unlock(st);
+    return n;
+}
+
+int store_top(Store *st, LeaderEntry *out, int k) {
+    int n = 0;
+    if (k <= 0 || store_lock(st) < 0) return 0;
+    collect_top(st, st->hdr->root, out, k, &n);
+    store_unlock(st);
+    return n;
+}
+
+uint32_t store_rank(Store *st, const char *name, PlayerStats *out) {
+    char key[STORE_NAME_SIZE] = {0};
+    strncpy(key, name, STORE_NAME_SIZE - 1);
+
+    if (store_lock(st) < 0) return 0;
+    StoreRecord *r = probe(st->records, st->capacity, key, name_hash(key));
+    uint32_t rank = 0;
+
+    if (r->hash && r->size) {
+        // Count everything ranking ahead on the way down to r
+        uint32_t t = st->hdr->root;
+        while (t) {
+            StoreRecord *n = node(st, t);
+            if (n == r) {
+                rank += subtree_size(st, n->left) + 1;
+                break;
+            }
+            if (ranks_ahead(r, n)) {
+                t = n->left;
+            } else {
+                rank += subtree_size(st, n->left) + 1;
+                t = n->right;
+            }
+        }
+        if (out) {
+            out->games = r->games;
+            out->wins = r->wins;
+            out->high_score = r->high_score;
+            out->total_score = r->total_score;
+        }
+    }
+    store_unlock(st);
+    return rank;
+}
@@ -0,0 +1,116 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Persistent name -> stats store kept in one mmap'd file.
+//
+// The file is a header followed by an open-addressing hash table (linear
+// probing, power-of-two capacity). Lookups and updates hash the name, walk
+// a short probe run and touch the record in place, so the cost per join is
+// the same with ten players on file as with a few hundred thousand. Records
+// are never deleted, so there are no tombstones.
+//
+// Writers in different processes (fork mode) and threads (pool mode) are
+// serialized by a robust process-shared mutex that lives in the header. The
+// header has its own page and mapping, so the mutex never moves; only the
+// table behind it is remapped. When the table passes 3/4 full it doubles in
+// place and every handle notices the new capacity the next time it takes
+// the lock.
+//
+// The same records also form the leaderboard: a treap (randomized balanced
+// search tree) ordered by rank and threaded through the table by slot
+// index, with subtree sizes kept on every node. Finishing a game unlinks
+// the player's node, updates the stats and relinks it, so the ranking is
+// maintained incrementally and top-K and rank-of-player queries cost
+// O(log n) (plus K) instead of a scan. Growing the table rebuilds the tree
+// in one pass over the records sorted by rank.
+//
+// Rank order: most wins, then best average score, then best high score,
+// then name.
+
+#define STORE_MAGIC        0x59535432u     // "YST2"
+#define STORE_MAGIC_V1     0x59535442u     // "YSTB": no leaderboard, migrated on open
+#define STORE_HEADER_SIZE  4096
+#define STORE_NAME_SIZE    56
+#define STORE_MIN_CAP      1024
+
+typedef struct {
+    uint32_t hash;                         // 0 marks an empty slot
+    uint32_t games;
+    uint32_t wins;
+    uint32_t high_score;
+    uint64_t total_score;
+    uint32_t left, right;                  // leaderboard links: slot + 1, 0 = none
+    uint32_t size;                         // records in this leaderboard subtree
+    uint32_t pad;
+    char name[STORE_NAME_SIZE];
+} StoreRecord;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;                     // slots, power of two
+    uint32_t count;                        // occupied slots
+    uint32_t root;                         // leaderboard root: slot + 1, 0 = empty
+    pthread_mutex_t lock;
+} StoreHeader;
+
+typedef struct {
+    int fd;
+    StoreHeader *hdr;
+    StoreRecord *records;
+    uint32_t capacity;                     // capacity of the current table mapping
+    int bulk;                              // between store_import_begin and _end
+} Store;
+
+typedef struct {
+    uint32_t games;
+    uint32_t wins;
+    uint32_t high_score;
+    uint64_t total_score;
+} PlayerStats;
+
+typedef struct {
+    char name[STORE_NAME_SIZE];
+    PlayerStats stats;
+} LeaderEntry;
+
+// Open (creating if needed) the store at `path`. Only one process should
+// open a given file; children inherit the mapping across fork. Sets
+// *created when the file was new or unreadable and started empty.
+// Returns NULL on error.
+Store* store_open(const char *path, int *created);
+void store_close(Store *st);
+
+// Returns 1 and fills *out if `name` is on file, 0 otherwise.
+int store_lookup(Store *st, const char *name, PlayerStats *out);
+
+// Add one finished game for `name`. Returns 0, or -1 if the table could not grow.
+int store_record_game(Store *st, const char *name, int score, int won);
+
+// Overwrite the win count for `name`, creating it if needed (legacy import).
+int store_set_wins(Store *st, const char *name, uint32_t wins);
+
+// Bracket a bulk load. In between, updates leave the leaderboard empty and
+// store_import_end builds it once from the sorted records, instead of
+// relinking a node per update and the whole tree on every table doubling.
+void store_import_begin(Store *st);
+void store_import_end(Store *st);
+
+uint32_t store_count(Store *st);
+
+// Copy the best `k` players into `out`, best first. Returns how many.
+int store_top(Store *st, LeaderEntry *out, int k);
+
+// 1-based leaderboard position of `name` (filling *out if non-NULL), or 0 if
+// the name is not on file.
+uint32_t store_rank(Store *st, const char *name, PlayerStats *out);
+
+// Average points per finished game, 0 before the first one
+static inline double player_average(const PlayerStats *s) {
+    return s->games ? (double)s->total_score / s->games : 0.0;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "solver.h"
+
+// Offline builder for the strategy table the server maps at startup.
+// Usage: strategy_gen [-j THREADS] [--compare] [output]   (default strategy.bin)
+//
+// -j defaults to every online core. --compare also runs the build on one
+// thread, checks both tables are identical and reports the speedup.
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-j THREADS] [--compare] [output]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = SOLVER_FILE;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int compare = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare = 1;
+        } else if (argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    size_t bytes = sizeof(float) * SOLVER_NUM_STATES;
+    float *values = (float*)malloc(bytes);
+    if (!values) {
+        perror("malloc");
+        return 1;
+    }
+
+    long reachable = 0;
+    for (int used = 0; used < SOLVER_NUM_MASKS; used++)
+        for (int upper = 0; upper <= SOLVER_UPPER_CAP; upper++)
+            for (int y = 0; y <= 1; y++)
+                reachable += solver_state_reachable(used, upper, y);
+
+    double t0 = now_sec();
+    long steals = solver_build(values, threads);
+    double dt = now_sec() - t0;
+    if (steals < 0) {
+        perror("solver_build");
+        return 1;
+    }
+    printf("build: %ld reachable states, %d thread%s, %.2f s (%ld steals)\n",
+           reachable, threads, threads == 1 ? "" : "s", dt, steals);
+
+    int rc = 0;
+    if (compare) {
+        float *single = (float*)malloc(bytes);
+        if (!single) {
+            perror("malloc");
+            return 1;
+        }
+        t0 = now_sec();
+        solver_build(single, 1);
+        double dt1 = now_sec() - t0;
+
+        int same = memcmp(single, values, bytes) == 0;
+        printf("single-threaded: %.2f s, speedup %.2fx on %d threads, tables %s\n",
+               dt1, dt1 / dt, threads, same ? "identical" : "DIFFER");
+        if (!same) rc = 1;
+        free(single);
+    }
+
+    if (solver_write(path, values) < 0) {
+        perror(path);
+        free(values);
+        return 1;
+    }
+    printf("%s: expected score of a new game %.2f\n", path, values[solver_state_index(0, 0, 0)]);
+    free(values);
+    return rc;
+}